@@ -0,0 +1,53 @@
+#pragma once
+
+// C/C++ Includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace flxrd
+{
+  /// Poisson bootstrap weights, for the statistical uncertainty of the flux files in one pass
+  /// Each entry gets one Poisson(1) weight per replica, and each replica histogram is filled with
+  /// the nominal weight times that entry's replica weight
+  /// The spread of the replicas estimates the statistical uncertainty of any quantity made from them
+  /// The weights come from a counter-based generator keyed on the seed, file name, and entry number,
+  /// so they are the same in every job and for every Spectra, regardless of the other input files
+  class Bootstrap
+  {
+  public:
+    /// \param nReplicas Number of replicas, 0 to turn the bootstrap off
+    /// \param seed Change this to get an independent set of replicas
+    Bootstrap(int nReplicas = 0, uint64_t seed = 0);
+
+    /// Return the number of replicas
+    int NReplicas() const { return fWeights.size(); }
+
+    /// Return the seed
+    uint64_t Seed() const { return fSeed; }
+
+    /// Calculate the replica weights of an entry of a file
+    /// \param fileKey Identifies the file, see FileKey
+    /// \param entry Entry number inside the file's tree
+    void SetEntry(uint64_t fileKey, int64_t entry);
+
+    /// Replica weights of the current entry, one per replica
+    const double* Weights() const { return fWeights.data(); }
+
+    /// Key of a flux file, made from its name without the directory,
+    /// so the replicas do not change if the files are moved
+    /// \param fullPath Use the full path instead, for input files that share a name in different directories
+    static uint64_t FileKey(const std::string& fileName, bool fullPath = false);
+
+  private:
+    /// One step of the SplitMix64 generator, which turns a counter into 64 random bits
+    static uint64_t SplitMix64(uint64_t x);
+
+    /// Draw from a Poisson distribution with mean 1 from 64 random bits
+    static int Poisson1(uint64_t bits);
+
+    uint64_t fSeed; ///< Seed of every replica weight
+
+    std::vector<double> fWeights; ///< Replica weights of the current entry
+  };
+}
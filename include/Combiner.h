@@ -4,18 +4,22 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 // Package Includes
 #include "Detector.h"
 
 // Forward Class Definitions
+class TDirectory;
 class TFile;
 class TH1;
 class TH2D;
+class TKey;
 
 namespace flxrd
 {
   class Parameters;
+  class SpectraMeta;
 
   /// Combiner is a class which reads a FluxReader output file,
   /// reads its parameters, and can combine its contents
@@ -40,7 +44,42 @@ namespace flxrd
     /// i.e., the result combines all neutrinos 
     void CombineAll();
 
+    /// Combine independent Spectra and detector pairs in this many threads
+    /// Each thread reads from its own handle of the file, and only the main thread writes
+    /// The default is 1; 0 uses all available cores
+    void SetNThreads(unsigned int n_threads);
+
+    /// Combine the histograms of one detector and cross section
+    /// \param first The master index of the first flavor and parent
+    /// \param hists The n_flav*n_par histograms in Parameters order, with nullptr for missing ones
+    /// The requested combinations are appended to combined, named as the Combiner writes them
+    /// This is also used by Spectra to combine histograms in memory when they are written
+    static void CombineHists(Parameters& params, std::string spec, int first,
+                             const std::vector<TH1*>& hists,
+                             bool nuflavs, bool parents, bool all,
+                             std::vector<TH1*>& combined);
+
   private:
+    /// Make the requested combinations for every Spectra and detector
+    void Combine(bool nuflavs, bool parents, bool all);
+
+    /// Read each histogram of one Spectra and detector once,
+    /// and add the requested combinations to the combined vector
+    void CombineGroup(Parameters& params, std::string spec, int i_det, TDirectory* dir,
+                      bool nuflavs, bool parents, bool all,
+                      std::vector<TH1*>& combined);
+
+    /// Name of a combined histogram, with the flavor and/or parent replaced by allnu and/or allpar
+    static std::string CombinedName(Parameters& params, std::string spec, int index,
+                                    bool allNu, bool allPar);
+
+    /// Sum n of the histograms, starting at index and separated by step
+    /// Returns nullptr if none of the histograms exist
+    static TH1* SumHists(const std::vector<TH1*>& hists, int index, int step, int n);
+
+    /// Returns true if the key points to a directory, without reading the object
+    static bool IsDirectory(TKey* key);
+
     /// Returns true if any histgorams in a FluxReader output file contain
     /// the string "search" in their name
     bool CombineAlreadyCalled(std::string search);
@@ -57,6 +96,10 @@ namespace flxrd
                          std::set<std::string>& parents,
                          std::set<std::string>& xsecs);
 
+    /// Sets up a Parameters object from the metadata written by FluxReader,
+    /// keeping the order and PDGs of the original Parameters
+    void SetupParameters(Parameters* params, const SpectraMeta& meta);
+
     /// Map pointing from a Spectra name to its associated Parameters
     std::map<std::string, Parameters> fParamsMap;
 
@@ -64,5 +107,7 @@ namespace flxrd
     std::set<std::string> fSpectra;
 
     TFile* fOut;
+
+    unsigned int fNThreads; ///< Number of threads used to combine histograms
   };
 }
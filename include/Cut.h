@@ -0,0 +1,76 @@
+#pragma once
+
+// C/C++ Includes
+#include <functional>
+#include <set>
+#include <string>
+
+// Other External Includes
+#include "dk2nu.h"
+
+namespace flxrd
+{
+  /// \brief A class which represents a selection applied to flux file entries
+  ///
+  /// A Cut takes a list of variables that need to be read from a flux file,
+  /// and a function which determines whether an entry is selected
+  /// A Spectra with a Cut only evaluates its Vars and Weight for entries that pass it
+  /// Cuts act on the whole entry, before the neutrino rays are pointed at the detectors,
+  /// so they must not use the nuray branch
+  /// Cuts can be combined with &&, ||, and !
+  class Cut
+  {
+  public:
+    /// This is the standard format for the Cut function
+    /// The Dk2Nu object stores all necessary values for a given entry
+    typedef bool (CutFunc_t)(const bsim::Dk2Nu* nu);
+
+    /// A Cut that selects every entry
+    Cut() : fID(0) {}
+
+    Cut(const std::set<std::string>& branches,
+        const std::function<CutFunc_t>& func)
+      : fBranches(branches), fFunc(func), fID(NextID()) {}
+
+    /// Copy constructor
+    /// A copy is the same Cut, so FluxReader only evaluates it once per entry
+    Cut(const Cut& copy) : fBranches(copy.fBranches), fFunc(copy.fFunc), fID(copy.fID) {}
+
+    Cut& operator=(const Cut& copy) = default;
+
+    /// Return the list of branches needed for the Cut
+    const std::set<std::string>& Branches() const { return fBranches; }
+
+    /// Return an identifier shared by all copies of the Cut
+    /// The Cut that selects every entry has identifier 0
+    int ID() const { return fID; }
+
+    /// Allow the Cut to be called as a function, i.e., cut(nu)
+    bool operator()(const bsim::Dk2Nu* nu) const
+    {
+      return !fFunc || fFunc(nu);
+    }
+
+  protected:
+    /// Get a new identifier
+    static int NextID();
+
+    std::set<std::string> fBranches; ///< List of branch names needed from the input flux file
+    std::function<CutFunc_t> fFunc; ///< The function that selects entries, empty to select every entry
+    int fID; ///< Identifier shared by all copies of the Cut
+  };
+
+  /// Select entries that pass both Cuts
+  /// The second Cut is only evaluated for entries that pass the first
+  Cut operator&&(const Cut& a, const Cut& b);
+
+  /// Select entries that pass either Cut
+  /// The second Cut is only evaluated for entries that fail the first
+  Cut operator||(const Cut& a, const Cut& b);
+
+  /// Select entries that fail the Cut
+  Cut operator!(const Cut& a);
+
+  /// All entries are selected
+  const Cut kNoCut;
+}
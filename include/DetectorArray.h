@@ -0,0 +1,85 @@
+#pragma once
+
+// C/C++ Includes
+#include <string>
+#include <vector>
+
+// Root Includes
+#include "TVector3.h"
+
+// Package Includes
+#include "Detector.h"
+
+// Forward Class Definitions
+namespace bsim { class Dk2Nu; }
+
+namespace flxrd
+{
+  /// Many detector positions sharing a name and target nucleus, e.g., off-axis positions of a movable detector
+  /// Each position is a point (like a Detector with 0 uses), in the same coordinates as a Detector (cm)
+  /// The neutrino ray energy and weight are calculated for all of the positions of an entry at once,
+  /// in one loop over contiguous arrays of coordinates, instead of one bsim::calcEnuWgt call per detector
+  class DetectorArray
+  {
+  public:
+    /// \param name The name of the array; this will be the detector name saved to file
+    /// \param positions Coordinates of each position (cm)
+    DetectorArray(const std::string& name, const std::string& target,
+                  const std::vector<TVector3>& positions);
+
+    /// A grid of positions at every combination of xs and ys, at the same z
+    /// Position i_x + i_y*xs.size() is at (xs[i_x], ys[i_y], z)
+    DetectorArray(const std::string& name, const std::string& target,
+                  const std::vector<double>& xs, const std::vector<double>& ys,
+                  const double& z);
+
+    /// Get the array name
+    std::string GetName() const { return fName; }
+
+    /// Get the target nucleus type shared by every position
+    std::string GetTarget() const { return fTarget; }
+
+    /// Get the number of positions
+    int NPositions() const { return fX.size(); }
+
+    /// Get the coordinates of a position
+    TVector3 GetPosition(int i_pos) const;
+
+    /// A Detector standing in for the whole array in a Parameters object,
+    /// with the array name and target, at the first position
+    Detector GetDetector() const;
+
+    /// Whether another array has the same target and exactly the same positions, in the same order
+    bool SamePositions(const DetectorArray& otherArray) const;
+
+    /// Calculate the neutrino ray energy and weight of an entry at every position
+    /// This gives the same results as bsim::calcEnuWgt, which is called directly for muon parents,
+    /// since those need a polarization correction for each position
+    void Reweight(const bsim::Dk2Nu* nu);
+
+    /// Neutrino ray energies and weights of the last entry passed to Reweight, one per position
+    const double* GetEnergies() const { return &fEnergy[0]; }
+    const double* GetWeights()  const { return &fWeight[0]; }
+
+    /// Print the array name, target, and positions
+    void PrintAll() const;
+
+    /// Simple method for comparing arrays, based on name comparison
+    bool operator<(const DetectorArray& otherArray) const
+    {
+      return (fName.compare(otherArray.fName) < 0);
+    }
+
+  private:
+    std::string fName;   ///< Array name
+    std::string fTarget; ///< Target nucleus of every position
+
+    /// Coordinates of each position (cm), stored separately so Reweight can loop over them in step
+    std::vector<double> fX;
+    std::vector<double> fY;
+    std::vector<double> fZ;
+
+    std::vector<double> fEnergy; ///< Neutrino ray energy at each position (GeV)
+    std::vector<double> fWeight; ///< Neutrino ray weight at each position
+  };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+// C/C++ Includes
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Root Includes
+#include "Rtypes.h"
+
+namespace flxrd
+{
+  /// A list of the entries of one flux file, grouped by neutrino flavor (decay.ntype)
+  /// and by ancestor, either the parent (decay.ptype) or the target exit ancestor (tgtexit.tptype)
+  /// It is built with one pass over those three branches,
+  /// and stored in a sidecar ROOT file so later jobs can skip straight to the entries they need
+  /// The sidecar is keyed by the flux file's path, size, and modification time,
+  /// so it is rebuilt if the flux file changes
+  class EntryIndex
+  {
+  public:
+    /// Function deciding whether entries with a neutrino flavor and ancestor PDG are needed
+    typedef bool (SelectFunc_t)(int nuPDG, int ancestorPDG);
+
+    EntryIndex() : fFileSize(0), fModTime(0), fNEntries(0) {}
+
+    /// Read the index of fileName from the sidecar file indexPath
+    /// Returns false if there is no sidecar, or it was made for a different version of the file
+    bool Read(const std::string& indexPath, const std::string& fileName);
+
+    /// Build the index of fileName by reading the flavor and ancestor branches of every entry
+    /// Only standard Dk2Nu trees can be indexed
+    /// Returns false if the file or tree cannot be read
+    bool Build(const std::string& fileName, const std::string& treePath);
+
+    /// Write the index to the sidecar file indexPath
+    /// It is written to a temporary file and renamed, so jobs writing the same sidecar at once do not clash
+    /// Returns false if the sidecar cannot be written, e.g., in a read only directory
+    bool Write(const std::string& indexPath) const;
+
+    /// Number of entries in the indexed tree
+    Long64_t NEntries() const { return fNEntries; }
+
+    /// Add the entries whose flavor and ancestor pass select to entries, offset by offset
+    /// \param ancestorPar Group by parent (true) or target exit ancestor (false)
+    void AddEntries(bool ancestorPar, const std::function<SelectFunc_t>& select,
+                    Long64_t offset, std::vector<Long64_t>& entries) const;
+
+    /// Get the size and modification time of a file
+    /// Returns false if the file cannot be found, e.g., a remote file
+    static bool FileStamp(const std::string& fileName, Long64_t& size, Long_t& modTime);
+
+    static const int kVersion = 1; ///< Current version of the sidecar format
+
+  private:
+    /// Name of the entry list of a flavor and ancestor in the sidecar file
+    static std::string ListName(bool ancestorPar, int nuPDG, int ancestorPDG);
+
+    std::string fFileName; ///< Path of the indexed flux file
+    Long64_t    fFileSize; ///< Size of the indexed flux file
+    Long_t      fModTime;  ///< Modification time of the indexed flux file
+    Long64_t    fNEntries; ///< Number of entries in the indexed tree
+
+    /// Sorted entry numbers for each (decay.ntype, decay.ptype) and (decay.ntype, tgtexit.tptype)
+    std::map<std::pair<int, int>, std::vector<Long64_t> > fParEntries;
+    std::map<std::pair<int, int>, std::vector<Long64_t> > fTgtEntries;
+  };
+}
@@ -10,12 +10,18 @@
 #include "TVector3.h"
 
 // Package Includes
+#include "Bootstrap.h"
+#include "Cut.h"
+#include "DetectorArray.h"
 #include "Parameters.h"
+#include "SmearSampler.h"
+#include "UniverseWeight.h"
 #include "Var.h"
 #include "Weight.h"
 
 // Forward Class Definitions
 class TBranch;
+class TChain;
 class TDirectory;
 class TH1;
 class TTree;
@@ -58,16 +64,121 @@ namespace flxrd
                     std::string labely, std::vector<double> binsy, const Var& vary,
                     std::string labelz, std::vector<double> binsz, const Var& varz,
                     const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+
+    /// Add a Spectra with one label, set of bin edges, and Var per axis, for 1 to 6 axes
+    /// The other AddSpectra functions are shortcuts for 1, 2, and 3 axes
+    void AddSpectra(Parameters params, std::string title,
+                    std::vector<std::string> labels,
+                    std::vector<std::vector<double> > bins,
+                    std::vector<Var> vars,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+
     void AddSpectra(Parameters params, std::string title,
                     std::string detX, std::string detY,
                     std::string labelx, std::vector<double> binsx, const Var& varx,
                     const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
 
+    /// Add a SpectraCorrDet that correlates every pair of the input detectors in one pass
+    /// For each pair, the detector that comes first in dets is the x axis detector
+    void AddSpectra(Parameters params, std::string title,
+                    std::vector<std::string> dets,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+
+    /// Add a SpectraUniverse, which fills the nominal histogram and every systematic universe in one pass
+    void AddSpectra(Parameters params, std::string title,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    const UniverseWeight& univWei,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+
+    /// Add a SpectraArray, which fills one variable at every position of a DetectorArray in one pass
+    /// The array replaces the detectors of params, and each histogram is the variable against the position
+    void AddSpectra(Parameters params, std::string title,
+                    const DetectorArray& array,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+
+    /// The same as above, but the Spectra is only filled with entries that pass the Cut
+    /// The Cut is evaluated before any of the Spectra's Vars or Weight,
+    /// and a Cut shared by several Spectra is only evaluated once per entry
+    void AddSpectra(Parameters params, std::string title,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    const Cut& cut,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+    void AddSpectra(Parameters params, std::string title,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    std::string labely, std::vector<double> binsy, const Var& vary,
+                    const Cut& cut,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+    void AddSpectra(Parameters params, std::string title,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    std::string labely, std::vector<double> binsy, const Var& vary,
+                    std::string labelz, std::vector<double> binsz, const Var& varz,
+                    const Cut& cut,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+    void AddSpectra(Parameters params, std::string title,
+                    std::vector<std::string> labels,
+                    std::vector<std::vector<double> > bins,
+                    std::vector<Var> vars,
+                    const Cut& cut,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+    void AddSpectra(Parameters params, std::string title,
+                    std::string detX, std::string detY,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    const Cut& cut,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+    void AddSpectra(Parameters params, std::string title,
+                    std::vector<std::string> dets,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    const Cut& cut,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+    void AddSpectra(Parameters params, std::string title,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    const UniverseWeight& univWei, const Cut& cut,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+    void AddSpectra(Parameters params, std::string title,
+                    const DetectorArray& array,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    const Cut& cut,
+                    const Weight& wei = kDefaultW, TObject* extWeights = nullptr);
+
     /// Allow FluxReader to read files that are not standard Dk2Nu files
     void OverrideTreeName(std::string treepath);
     void OverridePOTPath(std::string metapath, std::string potpath);
     void OverrideDefaultVarName(std::string oldname, std::string newname);
 
+    /// Histograms are only allocated once they receive an entry, and by default only those are written
+    /// Set this to write empty placeholders for every Parameters combination as well
+    void SetWriteEmptyHists(bool writeEmpty = true);
+
+    /// Only visit the entries whose neutrino flavor and parent some Spectra includes,
+    /// using an index of each input file built on the first job that reads it
+    /// This helps studies of rare flavors or parents most, e.g., only electron neutrinos from K+ decays
+    /// \param indexDir Directory of the index files; by default, each is written next to its input file
+    ///                 Files that cannot be indexed (e.g., remote files) turn the index off for the job
+    void UseEntryIndex(std::string indexDir = "");
+
+    /// Also write histograms combined over neutrino flavors and parents (allnu, allpar, and allnu_allpar),
+    /// summed in memory, so Combiner::CombineAll does not need to be run on the output file
+    /// SpectraCorrDet always writes its combinations, so this has no effect on it
+    void SetCombineHists(bool combine = true);
+
+    /// Fill Poisson bootstrap replicas of every Spectra(N)D and SpectraCorrDet,
+    /// in the same pass as the nominal histograms, and write the spread of the replicas as the statistical error,
+    /// in the bootstrap directory of each Spectra
+    /// The replica weights only depend on the seed, file name, and entry, so split jobs can be added together
+    /// If input files share a name in different directories, their full paths are used instead of their names
+    /// SpectraUniverse and SpectraArray do not fill replicas
+    /// \param nReplicas Number of replicas, 0 to turn the bootstrap off
+    /// \param seed Change this for an independent set of replicas
+    void SetBootstrap(int nReplicas, unsigned long long seed = 0);
+
+    /// Choose how the uses of a neutrino ray are smeared through a detector (see SmearSampler)
+    /// By default, each use is an independent random point
+    /// SmearSampler::kStratified and SmearSampler::kHalton spread the uses evenly through the detector,
+    /// which reaches the same smoothness with far fewer uses (see Demo11)
+    void SetSmearMode(SmearSampler::Mode mode);
+
   private:
     /// Add branch(es) to the master list of branches to turn on
     void AddBranch(std::string branchName);
@@ -76,6 +187,36 @@ namespace flxrd
     /// Add the pre-defined list of branches to the master list
     void AddDefaultBranches();
 
+    /// Store a new Spectra, with the Cut that selects its entries
+    void StoreSpectra(Spectra* s, const Cut& cut);
+
+    /// Evaluate each distinct Cut once for the current entry, and store the results in fCutPass
+    /// Returns false if every Spectra rejects the entry, by its Cut or by its Parameters' flavors and parents
+    /// Only needs the selection branches to have been read
+    bool SelectEntry();
+
+    /// Split the active branches into the selection branches, which are read for every entry,
+    /// and the payload branches, which are only read for entries that at least one Spectra selects
+    /// Only branches without active sub-branches are read directly,
+    /// so a Cut must list the sub-branches it uses, as Vars do (e.g., "decay.vz", not only "decay")
+    void SplitBranches();
+
+    /// Point fSelectBranches and fPayloadBranches to the TBranches of the tree that was just loaded
+    /// Returns the total (uncompressed) size of those branches in the tree
+    double LoadStageBranches(TTree* fluxTree);
+
+    /// Fill entries with the chain entry numbers whose flavor and parent some Spectra includes,
+    /// reading the index of each input file, or building and writing it if it is missing or stale
+    /// Every entry of a file that cannot be indexed (e.g., a remote file) is included, taking its range from chain
+    /// Returns false if the files are not standard Dk2Nu files, so none can be indexed
+    bool IndexEntries(TChain* chain, std::vector<Long64_t>& entries);
+
+    /// Path of the index file of an input file
+    std::string IndexPath(const std::string& fileName) const;
+
+    /// Read the current tree entry of each branch, and return the number of bytes read
+    int ReadBranches(const std::vector<TBranch*>& branches, Long64_t treeEntry);
+
     /// Notify the user of the parameters to be run over
     void InitialMessage();
 
@@ -88,10 +229,11 @@ namespace flxrd
     /// Set up the map which points a detector name to its first index in the Dk2Nu object's NuRay vector
     void SetNuRayIndices();
 
-    /// Randomly pick a point somewhere in the detector
+    /// Pick the point of one use of the current neutrino ray somewhere in the detector,
+    /// after fSmearSampler.NewRay has been called for the detector
     /// \param rr For a non square detector, pick a point such that
     ///           x*x + y*y is less than \a rr
-    TVector3 Smear(const Detector& det, double rr = -1); // ISSUE
+    TVector3 Smear(const Detector& det, int i_use, double rr = -1); // ISSUE
 
     /// Convert from detector coordinates to beam coordinates
     void ToBeamCoords(const Detector& det, TVector3& xyz);
@@ -101,8 +243,21 @@ namespace flxrd
 
     std::map<std::string, std::string> fBranchOverrides; ///< Point default Dk2Nu branch name to non-standard branch name
 
+    std::map<std::string, std::string> fBranchPaths; ///< Point each active branch name to its path in the flux tree
+
+    std::set<std::string> fSelectBranchNames; ///< Branches needed to decide whether any Spectra selects an entry
+
+    std::vector<std::string> fSelectPaths;  ///< Paths of the selection branches that are read directly
+    std::vector<std::string> fPayloadPaths; ///< Paths of the other active branches that are read directly
+
+    std::vector<TBranch*> fSelectBranches;  ///< Selection branches of the current tree
+    std::vector<TBranch*> fPayloadBranches; ///< Payload branches of the current tree
+
     std::set<Detector> fDetectors; ///< List of detectors to point neutrino rays toward
 
+    /// Detector arrays to point neutrino rays toward, each reweighted once per entry for all of its Spectra
+    std::vector<DetectorArray> fArrays;
+
     std::vector<std::string> fInputFiles; ///< List of input files to run over
 
     bsim::Dk2Nu*  fNu;   ///< Dk2Nu object that will store values for each input file entry
@@ -112,11 +267,27 @@ namespace flxrd
 
     bool fReweightNuRay; ///< Helper to determine whether neutrino rays need to be reweighted
 
+    SmearSampler fSmearSampler; ///< Chooses the points of the uses of each neutrino ray
+
+    bool fWriteEmptyHists; ///< Write histograms for Parameters combinations that were never filled
+
+    bool fCombineHists; ///< Write combined histograms along with the individual ones
+
+    bool        fUseEntryIndex; ///< Only visit entries listed in the input file indices
+    std::string fIndexDir;      ///< Directory of the index files, or empty to write them next to the input files
+
+    Bootstrap             fBootstrap; ///< Replica weights of the current entry
+    std::vector<uint64_t> fFileKeys;  ///< Bootstrap key of each input file, by tree number
+
     /// Spectra vector
     /// All relevant functions are declared in the abstract Spectra class,
     /// so this vector can handle any dimensional Spectra object pointer
     std::vector<Spectra*> fSpectra;
 
+    std::vector<Cut>  fCuts;        ///< Each distinct Cut used by the Spectra
+    std::vector<int>  fSpectraCuts; ///< Index in fCuts of each Spectra's Cut, or -1 for a Spectra without one
+    std::vector<char> fCutPass;     ///< Whether the current entry passes each Cut in fCuts
+
     std::string fTreePath; ///< Path that points to the tree in each input file
     std::string fMetaPath; ///< Path that points to the metadata tree of an input file
     std::string fPOTPath;  ///< Path that points to the POT variable in the metadata tree
@@ -0,0 +1,53 @@
+#pragma once
+
+// C/C++ Includes
+#include <vector>
+
+// Forward Class Definitions
+class TSpline3;
+
+namespace flxrd
+{
+  /// A set of cubic splines that are always evaluated together at the same x value
+  /// The GENIE cross sections for one neutrino and target share the same energy knots,
+  /// so the knot search only needs to be done once for all of them,
+  /// and the polynomial coefficients of every spline are stored next to each other for each knot
+  /// If the knots are not shared, each spline is evaluated on its own
+  /// A null spline is an identity factor (no cross section), which is exactly 1 everywhere and is never evaluated
+  class MultiSpline
+  {
+  public:
+    MultiSpline() : fShared(false), fNKnots(0) {}
+
+    MultiSpline(const std::vector<TSpline3*>& splines);
+
+    /// Evaluate every spline at x
+    /// vals must have room for NSplines() values, which are in the same order as the input splines
+    /// The values match TSpline3::Eval, including extrapolation outside of the knots
+    void Eval(double x, double* vals) const;
+
+    /// Number of splines in the set
+    int NSplines() const { return fSplines.size(); }
+
+    /// Whether all of the non-identity splines have the same knots
+    bool IsShared() const { return fShared; }
+
+    /// Whether every spline in the set is an identity factor
+    bool IsIdentity() const { return fActive.empty(); }
+
+  private:
+    /// Find the polynomial segment to use for x, matching TSpline3::FindX and TSpline3::Eval
+    int FindSegment(double x) const;
+
+    std::vector<TSpline3*> fSplines; ///< The input splines
+
+    std::vector<int> fActive;   ///< Indices of the splines that need to be evaluated
+    std::vector<int> fIdentity; ///< Indices of the identity factors
+
+    bool fShared; ///< True if every non-identity spline has the same knots
+    int  fNKnots; ///< Number of knots in each spline
+
+    std::vector<double> fKnots;  ///< x value of each knot
+    std::vector<double> fCoeffs; ///< Polynomial coefficients (y, b, c, d), ordered as [knot][active spline][coefficient]
+  };
+}
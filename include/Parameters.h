@@ -62,10 +62,10 @@ namespace flxrd
     friend class Combiner;
     friend class FluxReader;
     friend class Spectra;
-    friend class Spectra1D;
-    friend class Spectra2D;
-    friend class Spectra3D;
+    template <int N> friend class SpectraND;
+    friend class SpectraArray;
     friend class SpectraCorrDet;
+    friend class SpectraUniverse;
 
     /// This is the default constructor for users
     Parameters(bool SignSensitive = true, bool verbosity = true);
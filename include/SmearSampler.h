@@ -0,0 +1,51 @@
+#pragma once
+
+// C/C++ Includes
+#include <array>
+#include <vector>
+
+namespace flxrd
+{
+  /// Chooses the points where the uses of a neutrino ray are smeared through a detector
+  /// Each point is in the unit cube, and FluxReader scales it to the detector size
+  /// With independent random points, the smearing noise of a histogram only falls as 1/sqrt(uses)
+  /// The other modes spread the uses of each neutrino ray evenly through the detector,
+  /// so the same smoothness is reached with far fewer uses:
+  /// kStratified is a Latin hypercube, with each axis split into one slice per use and one use in each slice
+  /// kHalton takes the first uses of the Halton sequence (bases 2, 3, and 5),
+  /// shifted by a random amount per neutrino ray (modulo 1), so the rays do not all share the same points
+  /// Each mode draws from gRandom, and every point is still uniform in the detector on average
+  class SmearSampler
+  {
+  public:
+    /// How the points of the uses of a neutrino ray are chosen
+    enum Mode {
+      kRandom,     ///< Independent uniform points, the original behavior
+      kStratified, ///< Latin hypercube, with a random permutation and position in each slice
+      kHalton      ///< Halton sequence with a random shift per neutrino ray
+    };
+
+    SmearSampler(Mode mode = kRandom);
+
+    /// Get the mode
+    Mode GetMode() const { return fMode; }
+
+    /// Prepare the points of every use of a neutrino ray in one detector
+    void NewRay(int nUses);
+
+    /// Point of use i_use of the current neutrino ray, with each coordinate in [0, 1)
+    void Point(int i_use, double* u);
+
+  private:
+    /// The radical inverse of i in a base, i.e., its digits mirrored about the decimal point
+    static double RadicalInverse(unsigned int i, unsigned int base);
+
+    Mode fMode; ///< How the points are chosen
+
+    int fNUses; ///< Number of uses of the current neutrino ray
+
+    std::array<double, 3> fShift; ///< Random shift of the Halton points of the current neutrino ray
+
+    std::array<std::vector<int>, 3> fSlices; ///< Slice of each use along each axis, for kStratified
+  };
+}
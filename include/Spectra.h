@@ -9,7 +9,9 @@
 
 // Package Includes
 #include "Detector.h"
+#include "MultiSpline.h"
 #include "Parameters.h"
+#include "SpectraMeta.h"
 #include "Var.h"
 #include "Weight.h"
 
@@ -21,6 +23,8 @@ class TSpline3;
 
 namespace flxrd
 {
+  class Bootstrap;
+
   /// This abstract class sets up some common elements for a dimensional Spectra
   /// The version with a set dimension will include a vector of histograms
   class Spectra
@@ -46,7 +50,7 @@ namespace flxrd
     std::set<std::string> BranchesToAdd() const { return fBranches; }
 
     /// Returns all detectors needed for the Spectra
-    std::set<Detector> Detectors() const;
+    virtual std::set<Detector> Detectors() const;
 
     /// Fill one of the histograms with an entry
     /// The correct histogram will be determined from fParams
@@ -54,14 +58,67 @@ namespace flxrd
 
     int GetAncestorPDG(bsim::Dk2Nu* nu) const;
 
+    /// Set the current neutrino flavor and parent of fParams from an entry
+    /// Returns false if the Parameters do not include them, so the entry is not filled
+    /// Only needs the decay.ntype and decay.ptype (or tgtexit.tptype) branches
+    bool SetCurrentEntry(bsim::Dk2Nu* nu);
+
+    /// The same as above, from the neutrino flavor and ancestor PDGs
+    /// The ancestor PDG is the parent or target exit ancestor, according to the Parameters
+    bool SetCurrentEntry(int nuPDG, int ancestorPDG);
+
+    /// Calculate the full weight of a neutrino ray for every cross section at once,
+    /// for the current neutrino flavor and detector i_det
+    /// The results are stored in fXSecWeights, in the same order as the Parameters cross sections
+    /// The Weight is only evaluated once if it is linear in its input weight
+    void CalcXSecWeights(bsim::Dk2Nu* nu, int i_nuray, int i_det);
+
+    /// Tell the user how many histograms were actually allocated by Fill
+    void MaterializedMessage(int n_made) const;
+
+    /// Bin of the axis with these edges containing x, with the same conventions as TAxis::FindBin
+    static int FindBin(const std::vector<double>& edges, double x);
+
     /// Fills the cross section spline map
     void SetupXSec();
 
     /// Write all of the histograms in the input directory
     virtual void WriteHists(TDirectory* dir) = 0;
 
+    /// Write the histogram of each master index in its detector directory of out
+    /// This is shared by the Spectra that fill their own stores, and only make histograms from them when needed,
+    /// through the four functions below
+    /// Master indices that never received an entry are skipped, unless placeholders were requested
+    void WriteStores(TDirectory* out);
+
+    /// Whether master index i_hist has filled contents that are not in a histogram yet
+    virtual bool HasStore(int i_hist) const { return false; }
+
+    /// The histogram of master index i_hist, or nullptr if it has not been made
+    virtual TObject* ExistingHist(int i_hist) const { return nullptr; }
+
+    /// Create the histogram of master index i_hist if needed, and copy its store into it
+    virtual void MakeStoredHist(int i_hist) {}
+
+    /// Free the store of master index i_hist once its histogram holds the contents
+    /// Anything else made from the store can be written next to the detector directory det_name of out
+    virtual void FreeStore(int i_hist, TDirectory* out, const std::string& det_name) {}
+
+    /// Whether this kind of Spectra fills bootstrap replicas when fBootstrap is set
+    virtual bool CanBootstrap() const { return false; }
+
+    /// Describe the Spectra, so it can be written next to the histograms
+    /// The base class fills the Parameters and title; each implementation adds its type and axes
+    virtual SpectraMeta MakeMeta() const;
+
+    /// Sum the histograms over flavors and parents in memory, and write them in each detector directory of out
+    /// The names and contents match those made by Combiner::CombineAll on the written histograms
+    /// \param hists All of the histograms, indexed by master index, with nullptr for those that were not written
+    void WriteCombinedHists(TDirectory* out, const std::vector<TH1*>& hists);
+
     /// Create a cross section label to identifty specific splines
     std::string XSecName();
+    std::string XSecName(int i_flav, int i_xsec, int i_det) const;
 
     std::set<std::string> fBranches; ///< List of flux file branches needed to be activated
 
@@ -78,9 +135,26 @@ namespace flxrd
 
     std::string fTitle; ///< Label to prefix all of the histograms
 
+    /// Histograms are only created the first time their master index is filled
+    /// If true, empty placeholders are written for master indices that were never filled
+    bool fWriteEmpty;
+
+    /// If true, histograms combined over flavors and parents are written as well,
+    /// so the Combiner does not need to be run afterward
+    bool fCombine;
+
     Var    fVarX; ///< Variable to fill the x axis
     Weight fWei; ///< How to weight each entry
 
-    std::map<std::string, TSpline3*> fXSecSplines; ///< Map of cross section splines
+    std::map<std::string, TSpline3*> fXSecSplines; ///< Map of cross section splines, owned by the XSecRegistry (nullptr for NoXSec)
+
+    /// All cross section splines for a neutrino flavor and detector, evaluated together
+    /// Indexed by i_det*NFlav() + i_flav
+    std::vector<MultiSpline> fXSecTables;
+
+    std::vector<double> fXSecValues;  ///< Cross section values of the current neutrino ray
+    std::vector<double> fXSecWeights; ///< Full weights of the current neutrino ray, one per cross section
+
+    const Bootstrap* fBootstrap; ///< Bootstrap replica weights of the current entry, set by FluxReader (nullptr for none)
   };
 }
@@ -0,0 +1,81 @@
+#pragma once
+
+// C/C++ Includes
+#include <string>
+#include <vector>
+
+// Package Includes
+#include "DetectorArray.h"
+#include "Spectra.h"
+
+namespace flxrd
+{
+  /// Implementation of the abstract Spectra class for a DetectorArray
+  /// It fills one variable at every position of the array, from energies and weights
+  /// that FluxReader calculates for all of the positions at once
+  /// The array stands in for the Parameters detectors, so each flavor, parent, and cross section has one histogram
+  /// The contents are stored as [position][bin] contiguous arrays,
+  /// and each histogram is written as a TH2D of the variable against the position index
+  /// See the documentation for the abstract implementation for more details
+  class SpectraArray: public Spectra
+  {
+  public:
+    friend class FluxReader;
+
+    ~SpectraArray();
+
+    /// Access one of the histograms
+    /// A histogram that has not been filled yet is created empty
+    TH1* GetHist(int i_hist);
+
+  protected:
+    /// Fill one of the histograms with an entry, at every position
+    /// The correct histogram will be determined from fParams,
+    /// which was declared in the abstract base Spectra class
+    void Fill(bsim::Dk2Nu* nu, std::map<std::string, int> nurayIndices);
+
+    void WriteHists(TDirectory* out);
+
+    /// The positions are reweighted by FluxReader through the array, not as detectors
+    std::set<Detector> Detectors() const { return std::set<Detector>(); }
+
+    /// Add the type and axes to the common description
+    /// The position is described as a second axis, and the coordinates of each position are listed
+    SpectraMeta MakeMeta() const;
+
+  private:
+    /// The bin contents of one histogram, for every position
+    struct Store {
+      std::vector<double> fSumw;  ///< Sum of weights, indexed by position*(number of bins + 2) + bin, empty until first filled
+      std::vector<double> fSumw2; ///< Sum of squared weights, with the same layout
+      double fEntries; ///< Number of fills
+    };
+
+    /// The detectors of params are replaced by array.GetDetector()
+    SpectraArray(Parameters params, std::string title, const DetectorArray& array,
+                 std::string labelx, std::vector<double> binsx, const Var& varx,
+                 const Weight& wei, TObject* extWeights = nullptr);
+
+    /// Copy of params with the array as its only detector
+    static Parameters ArrayParameters(Parameters params, const DetectorArray& array);
+
+    /// Create the histogram for a master index if needed, and copy its store into it
+    TH1* MakeHist(int i_hist);
+
+    /// Stores and histograms for Spectra::WriteStores
+    bool     HasStore(int i_hist) const;
+    TObject* ExistingHist(int i_hist) const;
+    void     MakeStoredHist(int i_hist);
+    void     FreeStore(int i_hist, TDirectory* out, const std::string& det_name);
+
+    DetectorArray fArray; ///< Positions to fill, with the name and target used in the Parameters
+
+    const DetectorArray* fRays; ///< The array reweighted by FluxReader for the current entry
+
+    std::vector<Store> fStores; ///< Bin contents for each master index
+    std::vector<TH1*>  fHists;  ///< Histograms written to file, nullptr until made from a store
+
+    std::string         fLabelX; ///< Label of the variable
+    std::vector<double> fBinsX;  ///< Bin edges of the variable
+  };
+}
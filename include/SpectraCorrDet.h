@@ -9,7 +9,11 @@ class TH2D;
 
 namespace flxrd
 {
-  /// Implementation of the abstract Spectra class correlating two detectors
+  /// Implementation of the abstract Spectra class correlating detectors
+  /// It correlates one pair of detectors, or every pair from a list of detectors
+  /// Each detector's values and weights are evaluated once per entry, and shared by all of its pairs
+  /// With a FluxReader bootstrap, every replica fills its own 2D histogram and norm, and is normalized by itself,
+  /// so the spread written in the bootstrap directory includes the correlation of the two (see WriteSpread)
   /// See the documentation for the abstract or 1D implementation for more details
   class SpectraCorrDet: public Spectra
   {
@@ -18,46 +22,105 @@ namespace flxrd
 
     ~SpectraCorrDet();
 
+    /// Access one of the histograms
+    /// The histograms of each pair follow those of the previous pair, in the order of the pairs
     TH1* GetHist(int i_hist);
 
   protected:
-    /// Fill the full 2D histograms and associated normalization histograms
-    /// fHists gets filled using the weight from the detY neutrino ray
-    /// fNorms gets filled using the weight from the detX neutrino ray
+    /// Fill the full 2D histograms and associated normalization histograms of every pair
+    /// The 2D histograms get filled using the weight from the detY neutrino ray
+    /// The norms get filled using the weight from the detX neutrino ray, once per x use for all of the y uses
+    /// The Var, its bin, and the Weight are evaluated once per use of each detector, not once per pair of uses,
+    /// and the pairs of uses are added directly into the bin arrays
     void Fill(bsim::Dk2Nu* nu, std::map<std::string, int> nurayIndices);
 
     void WriteHists(TDirectory* out);
 
+    /// Add the type, axes, and the detector pairs to the common description
+    SpectraMeta MakeMeta() const;
+
+    /// Bootstrap replicas are stored next to each histogram's and norm's bins
+    bool CanBootstrap() const { return true; }
+
   private:
+    /// One pair of correlated detectors and its histograms
+    struct DetPair {
+      int i_detX; ///< Index of the x axis detector in the internal Parameters object
+      int i_detY; ///< Index of the y axis detector in the internal Parameters object
+
+      std::vector<TH2D*> fHists; ///< Vector of 2D histograms of detX vs detY
+      std::vector<TH1D*> fNorms; ///< Vector of 1D histograms of events at detX
+      std::vector<TH2D*> fCross; ///< Vector of 2D histograms of the detX weight times the detY weight, for the errors
+
+      /// Sum of weights of each bootstrap replica of each 2D histogram and norm,
+      /// indexed by bin*NReplicas() + replica, empty until filled or without a bootstrap
+      std::vector<std::vector<double> > fRepHists;
+      std::vector<std::vector<double> > fRepNorms;
+    };
+
     SpectraCorrDet(Parameters params, std::string title,
                    std::string detX, std::string detY,
                    std::string labelx, std::vector<double> binsx, const Var& varx,
                    const Weight& wei, TObject* extWeights = nullptr);
 
+    /// Correlate every pair of the input detectors
+    /// For each pair, the detector that comes first in dets is the x axis detector
+    SpectraCorrDet(Parameters params, std::string title,
+                   std::vector<std::string> dets,
+                   std::string labelx, std::vector<double> binsx, const Var& varx,
+                   const Weight& wei, TObject* extWeights = nullptr);
+
     /// These functions combine histograms, much like a flxrd::Combiner
     /// However, the normalization histograms do not get written to file,
     /// so combining these plots is not (correctly) possible with a Combiner
     /// These functions combine the histograms correctly, before normalization
-    void CombineNuFlavs(std::vector<TH2D*>& newHists, std::vector<TH1D*>& newNorms);
-    void CombineParents(std::vector<TH2D*>& newHists, std::vector<TH1D*>& newNorms);
-    void CombineAll();
+    void CombineNuFlavs(const DetPair& pair, std::vector<TH2D*>& newHists, std::vector<TH1D*>& newNorms,
+                        std::vector<TH2D*>& newCross);
+    void CombineParents(const DetPair& pair, std::vector<TH2D*>& newHists, std::vector<TH1D*>& newNorms,
+                        std::vector<TH2D*>& newCross);
+    void CombineAll(DetPair& pair);
+
+    /// Sum the bootstrap replicas in the same combinations as CombineAll, in the same order
+    void CombineReplicas(DetPair& pair);
 /// FIX THE NAMING ISSUE
-    void CreateHists(std::string detX, std::string detY,
-                     std::string labelx, std::vector<double> binsx);
+    void CreateHists(DetPair& pair, std::string labelx, std::vector<double> binsx);
 
-    /// For each histogram in fHists,
-    /// normalize each column in fHists (variable value at detX)
-    /// by the corresponding fNorms histogram bin (total event weight at detX)
+    /// For each histogram of each pair,
+    /// normalize each column (variable value at detX)
+    /// by the corresponding norm histogram bin (total event weight at detX)
+    /// The numerator and the norm are filled by the same entries, so their errors are correlated
+    /// The errors are propagated with that correlation, treating each pair of an x use and a y use as one fill
     void Normalize();
 
-    std::vector<TH2D*> fHists; ///< Vector of 2D histograms of detX vs detY
-    std::vector<TH1D*> fNorms; ///< Vector of 1D histograms of events at detX
+    /// Write a copy of a normalized histogram of a pair into the bootstrap directory of out,
+    /// with the spread (standard deviation) of its normalized bootstrap replicas as the error of each bin
+    void WriteSpread(const DetPair& pair, int i_hist, TDirectory* out) const;
+
+    /// The first index in the NuRay vector of a detector, and its number of uses
+    void NuRayRange(const std::map<std::string, int>& nurayIndices, int i_det,
+                    int& first_nuray, int& n_use) const;
+
+    /// The weights at every use of detector i_det, with the cross sections of detector i_xsec_det
+    /// They are only calculated the first time they are needed for an entry
+    const std::vector<double>& UseWeights(bsim::Dk2Nu* nu, const std::map<std::string, int>& nurayIndices,
+                                          int i_det, int i_xsec_det);
+
+    std::vector<DetPair> fPairs; ///< All correlated pairs of detectors
+
+    std::vector<int> fCorrDets; ///< Indices of every detector used by a pair
+
+    /// Variable bins and weights of the current entry, evaluated once per detector use
+    /// The bins are indexed by detector, and the weights by i_xsec_det*NDet() + i_det,
+    /// each a vector indexed by i_use*NXSec() + i_xsec
+    std::vector<std::vector<int> >    fUseBins;
+    std::vector<std::vector<double> > fUseWeights;
+    std::vector<bool>                 fUseWeightsDone; ///< Whether each entry of fUseWeights is up to date
 
-    int i_detX; ///< Index of the x axis detector in the internal Parameters object
-    int i_detY; ///< Index of the y axis detector in the internal Parameters object
+    std::string         fLabelX; ///< Label of the variable shown on both axes
+    std::vector<double> fBinsX;  ///< Bin edges of the variable shown on both axes
 
-    bool fIsNormalized; ///< Helper to determine whether fHists have been normalized by fNorms yet
-    bool fAlreadyCombined; ///< Helper to determine whether fHists have been combined yet
+    bool fIsNormalized; ///< Helper to determine whether the histograms have been normalized by the norms yet
+    bool fAlreadyCombined; ///< Helper to determine whether the histograms have been combined yet
   };
 
 }
@@ -0,0 +1,76 @@
+#pragma once
+
+// C/C++ Includes
+#include <string>
+#include <utility>
+#include <vector>
+
+// Forward Class Definitions
+class TDirectory;
+
+namespace flxrd
+{
+  /// A description of a Spectra, written into its directory of a FluxReader output file
+  /// It records everything needed to rebuild the Parameters and axes,
+  /// so tools like the Combiner do not need to parse histogram names
+  /// It is stored as a TObjString named kName, with one line per field:
+  /// a key, followed by its values, all separated by tabs
+  class SpectraMeta
+  {
+  public:
+    /// Detector information needed to rebuild a Detector object
+    struct DetInfo {
+      std::string  name;
+      std::string  target;
+      unsigned int uses;
+    };
+
+    SpectraMeta() : fVersion(kVersion), fDim(0), fSignSensitive(true), fAncestorPar(true), fPOT(0.),
+                    fNReplicas(0), fBootstrapSeed(0) {}
+
+    /// Write the metadata into dir, replacing any that is already there
+    void Write(TDirectory* dir) const;
+
+    /// Read the metadata from dir
+    /// Returns false if dir has no metadata or it cannot be understood,
+    /// for example in a file written before the metadata existed
+    bool Read(TDirectory* dir);
+
+    /// Convert to and from the text that is written to file
+    std::string ToString() const;
+    bool FromString(const std::string& str);
+
+    /// True if this describes a SpectraCorrDet
+    bool IsCorrDet() const { return !fCorrDets.empty(); }
+
+    static const char* kName; ///< Name of the object in each Spectra directory
+    static const int   kVersion = 1; ///< Current version of the format
+
+    int fVersion; ///< Version of the format that was read
+
+    std::string fType;  ///< Class name of the Spectra, e.g., Spectra1D
+    int         fDim;   ///< Number of axes filled by the Spectra
+    std::string fTitle; ///< Common piece of the histogram titles
+
+    bool   fSignSensitive; ///< Parameters sign sensitivity
+    bool   fAncestorPar;   ///< Parameters split by parent (true) or target exit ancestor (false)
+    double fPOT;           ///< Total POT of the FluxReader job
+
+    std::vector<std::pair<std::string, int> > fNuFlavs; ///< Neutrino flavor names and PDGs, in Parameters order
+    std::vector<std::pair<std::string, int> > fParents; ///< Parent names and PDGs, in Parameters order
+    std::vector<std::string> fXSecs; ///< Cross section names, in Parameters order
+    std::vector<DetInfo>     fDets;  ///< Detectors, in Parameters order
+
+    std::vector<std::string>         fLabels; ///< Axis labels, one per axis
+    std::vector<std::vector<double> > fBins;  ///< Axis bin edges, one vector per axis
+
+    /// x and y axis detectors of each pair of a SpectraCorrDet, empty otherwise
+    std::vector<std::pair<std::string, std::string> > fCorrDets;
+
+    /// Coordinates (x, y, z) of each position of a SpectraArray, empty otherwise
+    std::vector<std::vector<double> > fPositions;
+
+    int                fNReplicas;     ///< Number of bootstrap replicas, 0 if there are none
+    unsigned long long fBootstrapSeed; ///< Seed of the bootstrap replicas
+  };
+}
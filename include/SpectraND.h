@@ -0,0 +1,122 @@
+#pragma once
+
+// C/C++ Includes
+#include <array>
+#include <string>
+#include <vector>
+
+// Package Includes
+#include "Spectra.h"
+
+namespace flxrd
+{
+  /// N dimensional implementation of the abstract Spectra class, for N from 1 to 6
+  /// Each histogram is filled into its own contiguous store of bin contents,
+  /// laid out like a ROOT histogram (including underflow and overflow), with x varying fastest
+  /// The dimension is known at compile time, so the Var evaluation and bin lookup loops are unrolled
+  /// When written, the store becomes a TH1D, TH2D, or TH3D (with the same contents, errors, and statistics
+  /// that filling the ROOT histogram directly would give), or a THnD for more than three dimensions
+  /// With a FluxReader bootstrap, the replicas are filled next to each histogram,
+  /// and their spreads are written in a bootstrap directory (see WriteSpread)
+  /// Spectra1D, Spectra2D, and Spectra3D are aliases of SpectraND<1>, SpectraND<2>, and SpectraND<3>
+  /// See the documentation for the abstract implementation for more details
+  template <int N>
+  class SpectraND: public Spectra
+  {
+  public:
+    friend class FluxReader;
+
+    ~SpectraND();
+
+    /// Access one of the histograms
+    /// A histogram that has not been filled yet is created empty
+    /// Only available up to three dimensions; above that, use GetObject
+    TH1* GetHist(int i_hist);
+
+    /// Access one of the histograms as it is written to file: a TH1D, TH2D, TH3D, or THnD
+    TObject* GetObject(int i_hist);
+
+  protected:
+    /// Fill one of the histograms with an entry
+    /// The correct histogram will be determined from fParams,
+    /// which was declared in the abstract base Spectra class
+    void Fill(bsim::Dk2Nu* nu, std::map<std::string, int> nurayIndices);
+
+    void WriteHists(TDirectory* out);
+
+    /// Add the type and axes to the common description
+    SpectraMeta MakeMeta() const;
+
+    /// Bootstrap replicas are stored next to each histogram's bins
+    bool CanBootstrap() const { return true; }
+
+  private:
+    /// Number of products of two different axes kept for the statistics
+    static const int kNCross = N*(N - 1)/2;
+
+    /// The bin contents and statistics of one histogram
+    struct Store {
+      std::vector<double> fSumw;  ///< Sum of weights in each bin, empty until first filled
+      std::vector<double> fSumw2; ///< Sum of squared weights in each bin
+
+      double fEntries; ///< Number of fills, including those outside of the axes
+      bool   fWeighted; ///< Whether any weight was not 1 (ROOT only stores squared weights in that case)
+
+      /// Statistics of the fills inside the axes, as kept by ROOT
+      double fTsumw;
+      double fTsumw2;
+      std::array<double, N>       fTsumwX;  ///< Sum of w*x for each axis
+      std::array<double, N>       fTsumwX2; ///< Sum of w*x*x for each axis
+      std::array<double, kNCross> fTsumwXY; ///< Sum of w*x_j*x_k for j < k, ordered by k and then j
+
+      /// Sum of weights of each bootstrap replica, indexed by cell*NReplicas() + replica,
+      /// empty without a bootstrap
+      std::vector<double> fReplicas;
+    };
+
+    /// Spectra with N axes, with one label, set of bin edges, and Var per axis
+    SpectraND(Parameters params, std::string title,
+              std::vector<std::string> labels, std::vector<std::vector<double> > bins,
+              std::vector<Var> vars,
+              const Weight& wei, TObject* extWeights = nullptr);
+
+    /// Sets up the (initially empty) stores and histogram slots
+    /// Called inside the constructor
+    void CreateHists();
+
+    /// Allocate the store for a master index the first time it is needed
+    void MakeStore(int i_hist);
+
+    /// Create the histogram for a master index if needed, and copy its store into it
+    TObject* MakeHist(int i_hist);
+
+    /// Copy a store into a ROOT histogram of the matching dimension
+    void CopyStore(const Store& store, TObject* obj) const;
+
+    /// Write a copy of a histogram into the bootstrap/det directory of out,
+    /// with the spread (standard deviation) of its bootstrap replicas as the error of each bin
+    void WriteSpread(int i_hist, TDirectory* out, const std::string& det_name);
+
+    /// Stores and histograms for Spectra::WriteStores
+    bool     HasStore(int i_hist) const;
+    TObject* ExistingHist(int i_hist) const;
+    void     MakeStoredHist(int i_hist);
+    void     FreeStore(int i_hist, TDirectory* out, const std::string& det_name);
+
+    std::vector<Var> fVars; ///< Variable for each axis (the first is also fVarX)
+
+    std::vector<Store>    fStores; ///< Bin contents for each master index
+    std::vector<TObject*> fHists;  ///< Histograms written to file, nullptr until made from a store
+
+    std::vector<std::string>          fLabels; ///< Axis labels used when a histogram is made
+    std::vector<std::vector<double> > fBins;   ///< Axis bin edges used when a histogram is made
+
+    std::array<int, N> fStrides; ///< Distance in the store between neighboring bins of each axis
+    int                fNCells;  ///< Number of bins in each store, including underflow and overflow
+  };
+
+  /// The 1D, 2D, and 3D Spectra are fixed dimension SpectraND
+  typedef SpectraND<1> Spectra1D;
+  typedef SpectraND<2> Spectra2D;
+  typedef SpectraND<3> Spectra3D;
+}
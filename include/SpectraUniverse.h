@@ -0,0 +1,78 @@
+#pragma once
+
+// C/C++ Includes
+#include <string>
+#include <vector>
+
+// Package Includes
+#include "Spectra.h"
+#include "UniverseWeight.h"
+
+namespace flxrd
+{
+  /// Implementation of the abstract Spectra class for systematic universes
+  /// It fills one variable for a nominal weight and every universe of a UniverseWeight at once
+  /// The Var, its bin, the Weight, and the cross sections are only evaluated once per neutrino ray,
+  /// and the universe weights once per neutrino ray for all of the universes
+  /// The contents are stored as [bin][universe] contiguous arrays, so each fill is one tight loop over universes
+  /// Each histogram is written as a TH2D of the variable against the universe,
+  /// with the nominal histogram in the universe -1 row, followed by universes 0 to N - 1
+  /// See the documentation for the abstract implementation for more details
+  class SpectraUniverse: public Spectra
+  {
+  public:
+    friend class FluxReader;
+
+    ~SpectraUniverse();
+
+    /// Access one of the histograms
+    /// A histogram that has not been filled yet is created empty
+    TH1* GetHist(int i_hist);
+
+  protected:
+    /// Fill one of the histograms with an entry
+    /// The correct histogram will be determined from fParams,
+    /// which was declared in the abstract base Spectra class
+    void Fill(bsim::Dk2Nu* nu, std::map<std::string, int> nurayIndices);
+
+    void WriteHists(TDirectory* out);
+
+    /// Add the type and axes to the common description
+    /// The universe is described as a second axis
+    SpectraMeta MakeMeta() const;
+
+  private:
+    /// The bin contents of one histogram, for the nominal weight and every universe
+    struct Store {
+      std::vector<double> fSumw;  ///< Sum of weights, indexed by bin*fNCols + column, empty until first filled
+      std::vector<double> fSumw2; ///< Sum of squared weights, with the same layout
+      double fEntries; ///< Number of fills
+    };
+
+    SpectraUniverse(Parameters params, std::string title,
+                    std::string labelx, std::vector<double> binsx, const Var& varx,
+                    const UniverseWeight& univWei,
+                    const Weight& wei, TObject* extWeights = nullptr);
+
+    /// Create the histogram for a master index if needed, and copy its store into it
+    TH1* MakeHist(int i_hist);
+
+    /// Stores and histograms for Spectra::WriteStores
+    bool     HasStore(int i_hist) const;
+    TObject* ExistingHist(int i_hist) const;
+    void     MakeStoredHist(int i_hist);
+    void     FreeStore(int i_hist, TDirectory* out, const std::string& det_name);
+
+    UniverseWeight fUnivWei; ///< How to weight each universe, relative to the nominal weight
+
+    std::vector<double> fUnivValues; ///< Universe weights of the current neutrino ray
+
+    std::vector<Store> fStores; ///< Bin contents for each master index
+    std::vector<TH1*>  fHists;  ///< Histograms written to file, nullptr until made from a store
+
+    std::string         fLabelX; ///< Label of the variable
+    std::vector<double> fBinsX;  ///< Bin edges of the variable
+
+    int fNCols; ///< Number of columns of each bin: the nominal weight, followed by each universe
+  };
+}
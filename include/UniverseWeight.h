@@ -0,0 +1,57 @@
+#pragma once
+
+// C/C++ Includes
+#include <functional>
+#include <set>
+#include <string>
+
+// Other External Includes
+#include "dk2nu.h"
+
+// Forward Class Definitions
+class TObject;
+
+namespace flxrd
+{
+  /// \brief A class which represents a set of systematic universe weights applied to neutrino events
+  ///
+  /// A UniverseWeight takes the number of universes, a list of variables that need to be read from a flux file,
+  /// and a function which calculates the weight of every universe for a neutrino ray at once
+  /// Each universe weight multiplies the nominal weight of the Spectra (the Weight and cross section),
+  /// so a universe weight of 1 reproduces the nominal histogram
+  class UniverseWeight
+  {
+  public:
+    /// This is the standard format for the UniverseWeight function
+    /// The Dk2Nu object stores all necessary values for a given entry
+    /// The i_nuray integer points to the necessary index in the Dk2Nu NuRay vector
+    /// The TObject* pointer is a set of weights calculated externally from the FluxReader package
+    /// The function fills univ, which has one element per universe
+    typedef void (UnivFunc_t)(const bsim::Dk2Nu* nu, const int& i_nuray, const TObject* extW, double* univ);
+
+    UniverseWeight(int nUniv,
+                   const std::set<std::string>& branches,
+                   const std::function<UnivFunc_t>& func)
+      : fNUniv(nUniv), fBranches(branches), fFunc(func) {}
+
+    /// Copy constructor
+    UniverseWeight(const UniverseWeight& copy) : fNUniv(copy.fNUniv), fBranches(copy.fBranches), fFunc(copy.fFunc) {}
+
+    /// Return the number of universes
+    int NUniv() const { return fNUniv; }
+
+    /// Return the list of branches needed for the UniverseWeight
+    const std::set<std::string>& Branches() const { return fBranches; }
+
+    /// Allow the UniverseWeight to be called as a function, i.e., univWei(nu, i_nuray, extW, univ)
+    void operator()(const bsim::Dk2Nu* nu, const int& i_nuray, const TObject* extW, double* univ)
+    {
+      fFunc(nu, i_nuray, extW, univ);
+    }
+
+  protected:
+    int fNUniv; ///< Number of universes
+    std::set<std::string> fBranches; ///< List of branch names needed from the input flux file
+    std::function<UnivFunc_t> fFunc; ///< The function to calculate the universe weights
+  };
+}
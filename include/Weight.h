@@ -27,16 +27,24 @@ namespace flxrd
     /// The TObject* pointer is a set of weights calculated externally from the FluxReader package
     typedef double (WeiFunc_t)(const double& w, const bsim::Dk2Nu* nu, const int& i_nuray, const TObject* extW);
 
+    /// \param linear Set to true if the function is proportional to its double input,
+    ///               i.e., func(a*w, ...) = a*func(w, ...)
+    ///               Spectra then only evaluate the Weight once per neutrino ray,
+    ///               and scale it by each cross section
     Weight(const std::set<std::string>& branches,
-           const std::function<WeiFunc_t>& func)
-      : fBranches(branches), fFunc(func) {}
+           const std::function<WeiFunc_t>& func,
+           bool linear = false)
+      : fBranches(branches), fFunc(func), fLinear(linear) {}
 
     /// Copy constructor
-    Weight(const Weight& copy) : fBranches(copy.fBranches), fFunc(copy.fFunc) {}
+    Weight(const Weight& copy) : fBranches(copy.fBranches), fFunc(copy.fFunc), fLinear(copy.fLinear) {}
 
     /// Return the list of branches needed for the Weight
     const std::set<std::string>& Branches() const { return fBranches; }
 
+    /// Return whether the Weight is proportional to its double input
+    bool IsLinear() const { return fLinear; }
+
     /// Allow the Weight to be called as a function, i.e., wei(w, nu, i_nuray, extW)
     double operator()(const double& w, const bsim::Dk2Nu* nu, const int& i_nuray, const TObject* extW)
     {
@@ -46,6 +54,7 @@ namespace flxrd
   protected:
     std::set<std::string> fBranches; ///< List of branch names needed from the input flux file
     std::function<WeiFunc_t> fFunc; ///< The function to calculate the weight
+    bool fLinear; ///< Whether the function is proportional to the input weight
   };
 
   /// All entries get weighted by 'importance weight'*'propagation weight'*'cross section'
@@ -53,7 +62,7 @@ namespace flxrd
   /// this default weight takes the input double as the weight.
   /// This allows the product above to be passed as an input
   const Weight kDefaultW({}, [](const double& w, const bsim::Dk2Nu*, const int&, const TObject*)
-                         { return w; });
+                         { return w; }, true);
 
   /// All entries have weight 1
   const Weight kNoWeight({}, [](const double&, const bsim::Dk2Nu*, const int&, const TObject*)
@@ -26,5 +26,5 @@ namespace flxrd
                    int bin = hExtW->FindFixBin(sqrt(px*px + py*py), pz);
                    if(bin == -1)
                      return 0.;
-                   return w*hExtW->GetBinContent(bin); });
+                   return w*hExtW->GetBinContent(bin); }, true);
 }
@@ -23,6 +23,7 @@ namespace flxrd
       ~XSec();
 
       /// Pulls the cross section for a given target, neutrino, interaction combinaton as a TGraph
+      /// Each graph is derived once and cached; the returned graph is a copy owned by the caller
       TGraph* GetGraph(int pdg, std::string tar, std::string type, bool eventRate = false);
 
       /// Generates a cross section ratio as a TGraph
@@ -41,13 +42,19 @@ namespace flxrd
                              int pdg2, std::string tar2, std::string type2,
                              bool eventRate = false, const char* opt = "", double begin_val = 0);
 
-      /// Generates a cross section plot as a TH1* with equally spaced bins
-      TH1* GetHist(TSpline3* s, int nbins, double min, double max);
-      TH1* GetHist(TSpline3* s, int nbins, const double* edges);
+      /// Generates a cross section plot as a TH1* with equally spaced bins or arbitrary bin edges
+      /// Each bin is the average of XSecEval over the bin, integrated analytically from the spline polynomials
+      /// These do not need the cross section file, so they can be called without an XSec object
+      /// \param precision Tolerance in x for finding where the spline crosses zero
+      static TH1* GetHist(TSpline3* s, int nbins, double min, double max, double precision = 1.e-9);
+      static TH1* GetHist(TSpline3* s, int nbins, const double* edges, double precision = 1.e-9);
 
       /// Get the string pointing to a directory containing specific cross section information
       std::string GetXSecGenStr() const { return fXSecGenStr; }
 
+      /// Get the molar mass of a base target or a compound, like CH2
+      double GetMolarMass(std::string tar);
+
       /// Check whether the input process is a valid one found in fIntType
       bool IsValidProcess(std::string type) const;
 
@@ -63,6 +70,14 @@ namespace flxrd
       /// List all of the PDG values of neutrinos
       void ListNuPDGs() const;
 
+      /// Also store derived graphs in this directory, one ROOT file per graph, so later jobs can reuse them
+      /// The cache files are keyed by the path, size, and modification time of the cross section file
+      /// Each is written once, to a temporary file that is renamed into place,
+      /// so jobs sharing the directory never see a partly written file
+      /// The directory can also be set with the environment variable FLXRD_XSECCACHE
+      /// An empty string turns off the on-disk cache
+      void SetCacheDir(std::string dir);
+
       /// Helper function which opens the file that contains the cross section information
       /// This should normally be left to its default value, and typically is not a function called by the user
       void SetXSecFile(std::string override = "You_really_should_not_override_if_possible");
@@ -70,6 +85,12 @@ namespace flxrd
       /// Evaluates s(x), returning s(x) if s(x) > 0 and 0 otherwise, as cross sections are always positive
       double XSecEval(TSpline3* s, double x);
 
+      /// Evaluates s at each of the n values in x, storing max(s(x), 0) in vals, the same as XSecEval
+      /// If sorted is true, x must be in increasing order, and the knot search continues from the previous point
+      /// Otherwise, each point gets its own binary search
+      static void XSecEval(TSpline3* s, int n, const double* x, double* vals, bool sorted = false);
+      static std::vector<double> XSecEval(TSpline3* s, const std::vector<double>& x, bool sorted = false);
+
     private:
       /// Helper function for computing the cross section using a compound
       /// When splitting a compound string into its constituent atoms,
@@ -78,9 +99,31 @@ namespace flxrd
       void AddElementToCompoundMap(std::string tar, int number,
                                    std::map<std::string, int>* map);
 
+      /// Set each bin of h to the average of XSecEval over the bin
+      static void FillBinAverages(TSpline3* s, TH1* h, double precision);
+
+      /// Integrate XSecEval(s, x), the positive part of the spline, from xmin to xmax
+      static double IntegratePositive(TSpline3* s, double xmin, double xmax, double precision);
+
       /// Generates a cross section from a chemical compound, like CH2
       TGraph* GetGraphCompound(std::string compound, int pdg, std::string type);
 
+      /// Pulls the cross section without checking the cache
+      TGraph* MakeGraph(int pdg, std::string tar, std::string type, bool eventRate);
+
+      /// Split a compound string into its constituent atoms and their coefficients
+      /// The result is stored, so each compound is only parsed once
+      const std::map<std::string, int>& ParseCompound(std::string compound);
+
+      /// Helper functions for the graph cache
+      std::string CacheKey(int pdg, std::string tar, std::string type, bool eventRate) const;
+      std::string CacheFileName(std::string key);
+      TGraph* ReadCachedGraph(std::string key);
+      void    WriteCachedGraph(std::string key, TGraph* g);
+
+      /// Remove all cached graphs from memory
+      void ClearCache();
+
       /// Helper functions which generate a string to be used as a histogram title
       std::string MakeXSecTitle(     int pdg,  std::string tar,  std::string type);
       std::string MakeXSecRatioTitle(int pdg1, std::string tar1, std::string type1,
@@ -90,6 +133,7 @@ namespace flxrd
       void NuElectronCheck(std::string& type, int pdg, bool inSetXSecGenStr);
 
       /// Read the input file and set up the valid user inputs
+      /// The inputs of each file are only read once per process and are shared by every XSec object
       void SetupValidInputs();
 
       /// Helper function which generates the string which will match one of the directories in the cross section file
@@ -102,6 +146,12 @@ namespace flxrd
 
       std::set<std::string> fIntType; ///< Valid interaction types
 
+      std::map<std::string, TGraph*> fGraphs; ///< In-memory cache of derived graphs
+      std::map<std::string, std::map<std::string, int> > fCompounds; ///< Parsed compounds: atom and number of atoms
+
+      std::string fCacheDir;   ///< Directory of the on-disk graph cache; empty if it is not used
+      std::string fCacheStamp; ///< Identifies the cross section file in the cache file names, set the first time it is needed
+
       TDirectory* fLocalDir; ///< Directory before opening fXSecFile used for the histogram scope
 
       std::map<std::string, double> fMolarMass; ///< Targets (not necessarily valid) and their molar masses 
@@ -111,6 +161,7 @@ namespace flxrd
       std::map<std::string, std::string> fTarget; ///< Valid targets and their molar masses
 
       TFile* fXSecFile; ///< File containing cross section information
+      std::string fXSecFileName; ///< Name of the file containing cross section information
       std::string fXSecGenStr; ///< Label pointing to the correct cross section in the cross section file
   };
 }
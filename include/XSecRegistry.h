@@ -0,0 +1,62 @@
+#pragma once
+
+// C/C++ Includes
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+// Forward Class Definitions
+class TSpline3;
+
+namespace flxrd
+{
+  class XSec;
+
+  /// A process-wide store of cross section splines
+  /// The cross section file is opened once, on the first request,
+  /// and each spline is built once and shared by every Spectra (and FluxReader) that needs it
+  /// The same file is also used to validate cross section names, so Parameters does not need to open it again
+  /// All access is guarded by a mutex, so the registry can be used from multiple threads
+  class XSecRegistry
+  {
+  public:
+    /// Access the registry shared by the whole process
+    static XSecRegistry& Instance();
+
+    /// Get the spline for a neutrino PDG, target, and process,
+    /// creating it the first time this combination is requested
+    /// The process "NoXSec" is an identity factor and returns nullptr, which MultiSpline treats as exactly 1
+    /// The registry owns the returned spline; it must not be deleted or modified
+    TSpline3* GetXSec(int pdg, std::string tar, std::string type, bool eventRate = false);
+
+    /// Number of distinct splines that have been built
+    int NSplines();
+
+    /// Check whether the input process is valid, using the shared cross section file
+    /// "NoXSec" is always valid and does not need the file
+    bool IsValidProcess(std::string type);
+
+    /// List all the cross section interaction types
+    void ListIntTypes();
+
+  private:
+    XSecRegistry();
+
+    XSecRegistry(const XSecRegistry&) = delete;
+    XSecRegistry& operator=(const XSecRegistry&) = delete;
+
+    /// Get the shared cross section interface, opening the file on the first call
+    /// fMutex must already be locked
+    XSec* GetXSecObject();
+
+    /// Key identifying a spline: PDG, target, process, and whether it is scaled for an event rate
+    typedef std::tuple<int, std::string, std::string, bool> Key_t;
+
+    std::map<Key_t, TSpline3*> fSplines; ///< All splines that have been built
+
+    XSec* fXSec; ///< Cross section interface, created on the first request
+
+    std::mutex fMutex; ///< Guards fSplines and fXSec
+  };
+}
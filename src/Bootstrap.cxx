@@ -0,0 +1,71 @@
+#include "Bootstrap.h"
+
+// C/C++ Includes
+#include <cmath>
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  Bootstrap::Bootstrap(int nReplicas, uint64_t seed)
+    : fSeed(seed)
+  {
+    fWeights.assign(nReplicas > 0 ? nReplicas : 0, 1.);
+  }
+
+  //---------------------------------------------------------------------------
+  void Bootstrap::SetEntry(uint64_t fileKey, int64_t entry)
+  {
+    // Every (seed, file, entry) gets its own stream, and each replica is one counter step along it
+    const uint64_t stream = SplitMix64(fSeed ^ SplitMix64(fileKey ^ SplitMix64((uint64_t)entry)));
+
+    for(int i_rep = 0, n_rep = fWeights.size(); i_rep < n_rep; ++i_rep) {
+      fWeights[i_rep] = Poisson1(SplitMix64(stream + (uint64_t)(i_rep + 1)*0x9E3779B97F4A7C15ULL));
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  uint64_t Bootstrap::FileKey(const std::string& fileName, bool fullPath)
+  {
+    std::string base = (fullPath ? fileName : fileName.substr(fileName.find_last_of('/') + 1));
+
+    // FNV-1a hash of the name
+    uint64_t key = 0xCBF29CE484222325ULL;
+    for(const char c : base) {
+      key ^= (unsigned char)c;
+      key *= 0x100000001B3ULL;
+    }
+
+    return key;
+  }
+
+  //---------------------------------------------------------------------------
+  uint64_t Bootstrap::SplitMix64(uint64_t x)
+  {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+  }
+
+  //---------------------------------------------------------------------------
+  int Bootstrap::Poisson1(uint64_t bits)
+  {
+    static const double kExpMinus1 = std::exp(-1.);
+
+    // Invert the cumulative distribution, P(k) = e^-1/k!, with a uniform number from the top 53 bits
+    const double u = (bits >> 11)*(1./9007199254740992.);
+
+    int k = 0;
+    double p = kExpMinus1;
+    double cdf = p;
+    while(u >= cdf && k < 20) {
+      ++k;
+      p /= k;
+      cdf += p;
+    }
+
+    return k;
+  }
+}
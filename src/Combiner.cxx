@@ -1,8 +1,11 @@
 #include "Combiner.h"
 
 // C/C++ Includes
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <iostream>
+#include <thread>
 
 // Root Includes
 #include "TAxis.h"
@@ -13,9 +16,11 @@
 #include "TH1.h"
 #include "TH2D.h"
 #include "TKey.h"
+#include "TROOT.h"
 
 // Package Includes
 #include "Parameters.h"
+#include "SpectraMeta.h"
 #include "ParticleParam.h"
 
 namespace flxrd
@@ -26,6 +31,8 @@ namespace flxrd
     // Store current directory to come back to later
     TDirectory* temp = gDirectory;
 
+    fNThreads = 1; // By default, combine serially
+
     fOut = new TFile(out.c_str(), "UPDATE"); // Open the input file
     assert(fOut->IsOpen()); // Break if the file is unopened
 
@@ -34,7 +41,7 @@ namespace flxrd
     TKey* keySpec;
     while((keySpec = (TKey*)iterSpec())) {
       // This eliminates the TotalPOT histogram from being added
-      if( keySpec->ReadObj()->IsA()->InheritsFrom(TDirectory::Class()) ) {
+      if(IsDirectory(keySpec)) {
         fSpectra.insert(keySpec->GetName());
       }
     }
@@ -42,11 +49,43 @@ namespace flxrd
     delete keySpec;
 
     // For each Spectra object, build a Parameters object matching what was used to create the Spectra
+    // Spectra made with the same Parameters share one, so each distinct set is only built once
     // Keep track of SpectraCorrDet, since these don't get combined
+    std::map<std::string, Parameters> paramsCache;
     std::vector<std::string> corrDetSpec;
     for(const std::string& spec: fSpectra) {
       fOut->cd(spec.c_str()); // Go into the Spectra directory
 
+      // Files written with metadata describe each Spectra directly
+      SpectraMeta meta;
+      if(meta.Read(gDirectory)) {
+        // SpectraCorrDet write their own combinations, and more than three dimensions are not TH1s
+        if(meta.IsCorrDet() || meta.fDim > 3) {
+          corrDetSpec.push_back(spec);
+          continue;
+        }
+
+        // Label the parameters, including PDGs, so Spectra with the same ones can share a Parameters object
+        std::string paramsKey = "meta;";
+        for(const auto& flav : meta.fNuFlavs) { paramsKey += flav.first + ":" + std::to_string(flav.second) + ","; }
+        paramsKey += ";";
+        for(const auto& par : meta.fParents) { paramsKey += par.first + ":" + std::to_string(par.second) + ","; }
+        paramsKey += ";";
+        for(const auto& xsec : meta.fXSecs) { paramsKey += xsec + ","; }
+        paramsKey += ";";
+        for(const auto& det : meta.fDets) { paramsKey += det.name + ","; }
+
+        if(paramsCache.find(paramsKey) == paramsCache.end()) {
+          Parameters p;
+          SetupParameters(&p, meta);
+          paramsCache[paramsKey] = p;
+        }
+
+        fParamsMap[spec] = paramsCache[paramsKey];
+        continue;
+      }
+
+      // Otherwise, the parameters are found by parsing the histogram names
       // List of each parameter (aside from histogram titles, which is stored by the class)
       std::set<std::string> dets;
       std::set<std::string> nuflavs;
@@ -58,7 +97,7 @@ namespace flxrd
       TKey* keyDet;
       while((keyDet = (TKey*)iterDet())) {
         // Make sure only directories are added
-        if( keyDet->ReadObj()->IsA()->InheritsFrom(TDirectory::Class()) ) {
+        if(IsDirectory(keyDet)) {
           dets.insert(keyDet->GetName());
         }
       }
@@ -69,41 +108,63 @@ namespace flxrd
         corrDetSpec.push_back(spec);
       }
       else { // This is a Spectra1D/2D/3D
-        // Store, and go into the first detector directory
-        std::string firstDet = *(dets.begin());
-        gDirectory->cd(firstDet.c_str());
-
-        // Loop through the detector folder, over all histograms
-        TIter iterHist(gDirectory->GetListOfKeys());
-        TKey* keyHist;
-        while((keyHist = (TKey*)iterHist())) {
-          std::string histTitle = keyHist->GetName(); // Get a histogram name
-
-          // Remove the histogram title from the beginning, which has form "title_"
-          histTitle.erase(histTitle.begin(), histTitle.begin() + spec.length() + 1);
-          // Remove detector name from the end, which has the form "_detector"
-          histTitle.erase(histTitle.end() - firstDet.length() - 1, histTitle.end());
-          // The histogram title will have the remaining form flav_par_xsec
-
-          std::string nuflav = histTitle.substr(0, histTitle.find('_')); // Get the neutrino flavor
-          nuflavs.insert(nuflav); // Insert it into the neutrino flavors list
-          // Remove it from the histgoram title, leaving par_xsec
-          histTitle.erase(histTitle.begin(), histTitle.begin() + nuflav.length() + 1);
-
-          // Repeart for parent name, leaving just xsec
-          std::string parent = histTitle.substr(0, histTitle.find('_'));
-          parents.insert(parent);
-          histTitle.erase(histTitle.begin(), histTitle.begin() + parent.length() + 1);
-
-          xsecs.insert(histTitle); // Add xsec to list
+        // Histograms are only written for parameter combinations that were filled,
+        // so every detector directory needs to be checked to find all of the parameters
+        for(const std::string& det: dets) {
+          fOut->cd(spec.c_str());
+          gDirectory->cd(det.c_str());
+
+          // Loop through the detector folder, over all histograms
+          TIter iterHist(gDirectory->GetListOfKeys());
+          TKey* keyHist;
+          std::string lastName = "";
+          while((keyHist = (TKey*)iterHist())) {
+            std::string histTitle = keyHist->GetName(); // Get a histogram name
+
+            // Each cycle of a histogram has its own key; only parse the name once
+            if(!histTitle.compare(lastName)) { continue; }
+            lastName = histTitle;
+
+            // Remove the histogram title from the beginning, which has form "title_"
+            histTitle.erase(histTitle.begin(), histTitle.begin() + spec.length() + 1);
+            // Remove detector name from the end, which has the form "_detector"
+            histTitle.erase(histTitle.end() - det.length() - 1, histTitle.end());
+            // The histogram title will have the remaining form flav_par_xsec
+
+            std::string nuflav = histTitle.substr(0, histTitle.find('_')); // Get the neutrino flavor
+            // Remove it from the histgoram title, leaving par_xsec
+            histTitle.erase(histTitle.begin(), histTitle.begin() + nuflav.length() + 1);
+
+            // Repeart for parent name, leaving just xsec
+            std::string parent = histTitle.substr(0, histTitle.find('_'));
+            histTitle.erase(histTitle.begin(), histTitle.begin() + parent.length() + 1);
+
+            // Histograms combined when they were written are not inputs
+            if(!nuflav.compare("allnu") || !parent.compare("allpar")) { continue; }
+
+            nuflavs.insert(nuflav);
+            parents.insert(parent);
+            xsecs.insert(histTitle); // Add xsec to list
+          }
+        }
+
+        // Label the parameter lists, so Spectra with the same lists can share a Parameters object
+        std::string paramsKey = "";
+        for(const auto& list : { dets, nuflavs, parents, xsecs }) {
+          for(const std::string& name : list) {
+            paramsKey += name + ",";
+          }
+          paramsKey += ";";
         }
 
         // Create and set up a Parameters object with the parameters used to make the Spectra
-        Parameters* p = new Parameters();
-        SetupParameters(p, dets, nuflavs, parents, xsecs);
-        fParamsMap[spec] = *p; // Add the Parameters object to the map
+        if(paramsCache.find(paramsKey) == paramsCache.end()) {
+          Parameters p;
+          SetupParameters(&p, dets, nuflavs, parents, xsecs);
+          paramsCache[paramsKey] = p;
+        }
 
-        delete keyHist;
+        fParamsMap[spec] = paramsCache[paramsKey]; // Add the Parameters object to the map
       }
     }
 
@@ -126,212 +187,308 @@ namespace flxrd
   }
 
   //---------------------------------------------------------------------------
-  void Combiner::CombineNuFlavs()
+  void Combiner::SetNThreads(unsigned int n_threads)
   {
-    std::string rep_str = "allnu"; // This string will replace the neutrino flavor name
+    // Zero means use every available core
+    fNThreads = (n_threads > 0 ? n_threads : std::max(std::thread::hardware_concurrency(), 1u));
+    return;
+  }
 
+  //---------------------------------------------------------------------------
+  void Combiner::CombineNuFlavs()
+  {
     // Do nothing if neutrino flavors have already been combined
-    if(CombineAlreadyCalled(rep_str)) {
+    if(CombineAlreadyCalled("allnu")) {
       std::cout << "Neutrino flavors have already been combined." << std::endl;
       return;
     }
 
-    TDirectory* temp = gDirectory;
-
-    // Loop through each Spectra
-    for(const std::string& spec: fSpectra) {
-      fOut->cd(spec.c_str());
-
-      // Store number of each parameter in this Spectra
-      const unsigned int n_flav = fParamsMap[spec].NFlav();
-      const unsigned int n_par  = fParamsMap[spec].NPar();
-      const unsigned int n_xsec = fParamsMap[spec].NXSec();
-      const unsigned int n_det  = fParamsMap[spec].NDet();
-
-      for(unsigned int i_det = 0; i_det < n_det; ++i_det) {
-        gDirectory->cd(fParamsMap[spec].GetDetName(i_det).c_str());
-
-        for(unsigned int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
-          for(unsigned int i_par  = 0; i_par  < n_par;  ++i_par) {
-            // This corresponds to the way Parameters does indexing.
-            // NuFlav index 0 is used by not including "+ i_flav" at the end.
-            int index =   n_flav*n_par*n_xsec*i_det
-                        + n_flav*n_par*i_xsec
-                        + n_flav*i_par;
-
-            // Find/create the name of a stored histogram and copy it into a new histogram for combining
-            std::string hName = spec + "_" + fParamsMap[spec].NameTag(index);
-            TH1* h = (TH1*)((TH1*)gDirectory->Get(hName.c_str()))->Clone();
-
-            for(unsigned int i_flav = 1; i_flav < n_flav; ++i_flav) {
-              ++index; // This corresponds to an increment of the NuFlav index
-              hName = spec + "_" + fParamsMap[spec].NameTag(index); // Next histogram name
+    Combine(true, false, false);
+    return;
+  }
 
-              h->Add((TH1*)gDirectory->Get(hName.c_str())); // Add it into the combined histogram
-            }
+  //---------------------------------------------------------------------------
+  void Combiner::CombineParents()
+  {
+    if(CombineAlreadyCalled("allpar")) {
+      std::cout << "Parents have already been combined." << std::endl;
+      return;
+    }
 
-            // Replace neutrino flavor name by the replacement string
-            // The histogram name has format title_nuflav_par_xsec_det
-            int firstPos = hName.find('_');
-            int secndPos = hName.find('_', firstPos+1); // Search only after position specified in second argument
-            hName.replace(firstPos+1, secndPos-firstPos-1, rep_str);
-            h->SetName(hName.c_str()); // Give the combined histogram the correct name for writing to file
+    Combine(false, true, false);
+    return;
+  }
 
-            gDirectory->WriteTObject(h); // Save the histogram
-          } // Loop over parents
-        } // Loop over cross sections
+  //---------------------------------------------------------------------------
+  void Combiner::CombineAll()
+  {
+    if(CombineAlreadyCalled("allnu_allpar")) {
+      std::cout << "All possible plots have already been combined." << std::endl;
+      return;
+    }
 
-        fOut->cd(spec.c_str());
-      } // Loop over detectors
+    // The combined flavor and parent histograms are made along with the full combination,
+    // unless they already exist
+    bool nuflavs = !CombineAlreadyCalled("allnu");
+    if(!nuflavs) {
+      std::cout << "Neutrino flavors have already been combined." << std::endl;
+    }
 
-      fOut->cd();
-    } // Loop over Spectra
+    bool parents = !CombineAlreadyCalled("allpar");
+    if(!parents) {
+      std::cout << "Parents have already been combined." << std::endl;
+    }
 
-    temp->cd();
+    Combine(nuflavs, parents, true);
     return;
   }
 
   //---------------------------------------------------------------------------
-  void Combiner::CombineParents()
+  void Combiner::Combine(bool nuflavs, bool parents, bool all)
   {
-    // This function is similar to CombineNuFlav; see its comments for more details.
+    TDirectory* temp = gDirectory;
 
-    std::string rep_str = "allpar"; // This string will replace the parent name
+    // Every Spectra and detector pair is combined independently
+    // Each group has its own copy of the Parameters, since NameTag changes its indices
+    struct Group {
+      std::string spec;
+      int i_det;
+      Parameters params;
+      std::vector<TH1*> combined;
+    };
 
-    if(CombineAlreadyCalled(rep_str)) {
-      std::cout << "Parents have already been combined." << std::endl;
-      return;
+    std::vector<Group> groups;
+    for(const std::string& spec: fSpectra) {
+      for(int i_det = 0, n_det = fParamsMap[spec].NDet(); i_det < n_det; ++i_det) {
+        groups.push_back({spec, i_det, fParamsMap[spec], std::vector<TH1*>()});
+      }
     }
 
-    TDirectory* temp = gDirectory;
+    const int n_group = groups.size();
+    const unsigned int n_threads = std::min((unsigned int)n_group, fNThreads);
 
-    for(const std::string& spec: fSpectra) {
-      fOut->cd(spec.c_str());
+    // Work through the groups, reading the inputs from source
+    std::atomic<int> next(0);
+    auto work = [&](TFile* source) {
+      for(int i_group = next++; i_group < n_group; i_group = next++) {
+        Group& g = groups[i_group];
 
-      const unsigned int n_flav = fParamsMap[spec].NFlav();
-      const unsigned int n_par  = fParamsMap[spec].NPar();
-      const unsigned int n_xsec = fParamsMap[spec].NXSec();
-      const unsigned int n_det  = fParamsMap[spec].NDet();
+        std::string dirName = g.spec + "/" + g.params.GetDetName(g.i_det);
+        TDirectory* dir = source->GetDirectory(dirName.c_str());
 
-      for(unsigned int i_det = 0; i_det < n_det; ++i_det) {
-        gDirectory->cd(fParamsMap[spec].GetDetName(i_det).c_str());
+        CombineGroup(g.params, g.spec, g.i_det, dir, nuflavs, parents, all, g.combined);
+      }
+    };
+
+    if(n_threads > 1) {
+      ROOT::EnableThreadSafety();
+
+      // The combined histograms are clones, which ROOT adds to gDirectory (gROOT in a new thread)
+      // That list is not safe to add to from several threads, so keep the clones out of it
+      const bool addDirectory = TH1::AddDirectoryStatus();
+      TH1::AddDirectory(false);
+
+      // Each thread reads from its own handle of the file; only this thread writes
+      // Earlier calls may have written histograms through fOut that are not on disk yet,
+      // so write its keys and headers and flush it, so every input is visible to a new handle
+      fOut->Write();
+      fOut->Flush();
 
-        for(unsigned int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
-          for(unsigned int i_flav = 0; i_flav < n_flav; ++i_flav) {
-            // This corresponds to the way Parameters does indexing.
-            // Parent index 0 is used by not including the line "n_flav*i_par".
-            int index =   n_flav*n_par*n_xsec*i_det
-                        + n_flav*n_par*i_xsec
-                        + i_flav;
+      std::vector<std::thread> threads;
+      for(unsigned int i_thread = 0; i_thread < n_threads; ++i_thread) {
+        threads.emplace_back([&]() {
+          TFile* in = TFile::Open(fOut->GetName(), "READ");
+          assert(in && in->IsOpen());
 
-            std::string hName = spec + "_" + fParamsMap[spec].NameTag(index);
-            TH1* h = (TH1*)((TH1*)gDirectory->Get(hName.c_str()))->Clone();
+          work(in);
 
-            for(unsigned int i_par  = 1; i_par  < n_par;  ++i_par) {
-              index += n_flav; // This corresponds to an increment of the Parent index
-              hName = spec + "_" + fParamsMap[spec].NameTag(index);
+          in->Close();
+          delete in;
+        });
+      }
+
+      for(auto& thread : threads) {
+        thread.join();
+      }
 
-              h->Add((TH1*)gDirectory->Get(hName.c_str()));
-            }
+      TH1::AddDirectory(addDirectory);
+    }
+    else {
+      work(fOut);
+    }
 
-            // Replace neutrino flavor name by the replacement string
-            // The histogram name has format title_nuflav_par_xsec_det
-            int firstPos = hName.find('_');
-            firstPos = hName.find('_', firstPos+1); // Update to the next occurence of '_'
-            int secndPos = hName.find('_', firstPos+1);
-            hName.replace(firstPos+1, secndPos-firstPos-1, rep_str);
-            h->SetName(hName.c_str());
+    // Write all of the results, one group at a time
+    int n_combined = 0;
+    for(Group& g : groups) {
+      std::string dirName = g.spec + "/" + g.params.GetDetName(g.i_det);
+      TDirectory* dir = fOut->GetDirectory(dirName.c_str());
 
-            gDirectory->WriteTObject(h);
-          } // Loop over flavors
-        } // Loop over cross sections
+      for(TH1* h : g.combined) {
+        dir->WriteTObject(h); // Save the histogram
+        delete h;
+      }
 
-        fOut->cd(spec.c_str());
-      } // Loop over detectors
+      n_combined += g.combined.size();
+    }
 
-      fOut->cd();
-    } // Loop over Spectra
+    std::cout << "Combined " << n_group << " Spectra and detector pairs into "
+              << n_combined << " histograms using " << std::max(n_threads, 1u) << " thread(s)." << std::endl;
 
     temp->cd();
     return;
   }
 
   //---------------------------------------------------------------------------
-  void Combiner::CombineAll()
+  void Combiner::CombineGroup(Parameters& params, std::string spec, int i_det, TDirectory* dir,
+                              bool nuflavs, bool parents, bool all,
+                              std::vector<TH1*>& combined)
   {
-    // This function is similar to CombineNuFlav; see its comments for more details.
+    // Store number of each parameter in this Spectra
+    const int n_flav = params.NFlav();
+    const int n_par  = params.NPar();
+    const int n_xsec = params.NXSec();
+
+    for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+      // This corresponds to the way Parameters does indexing.
+      // NuFlav and parent index 0 are used by not including "+ n_flav*i_par + i_flav" at the end.
+      const int first =   n_flav*n_par*n_xsec*i_det
+                        + n_flav*n_par*i_xsec;
+
+      // Read each histogram with this cross section once
+      // Histograms are not written for combinations that were never filled, so some may be missing
+      // They are detached from the directory, so they belong only to this call
+      std::vector<TH1*> hists(n_flav*n_par, nullptr);
+      for(int i_hist = 0; i_hist < n_flav*n_par; ++i_hist) {
+        std::string hName = spec + "_" + params.NameTag(first + i_hist);
+        hists[i_hist] = (TH1*)dir->Get(hName.c_str());
+
+        if(hists[i_hist]) {
+          hists[i_hist]->SetDirectory(nullptr);
+        }
+      }
 
-    std::string nu_str  = "allnu"; // Replacement string for neutrino flavor name
-    std::string par_str = "allpar"; // Replacement string for parent name
-    std::string rep_str = nu_str + "_" + par_str; // Replacement string for both
+      CombineHists(params, spec, first, hists, nuflavs, parents, all, combined);
 
-    if(CombineAlreadyCalled(rep_str)) {
-      std::cout << "All possible plots have already been combined." << std::endl;
-      return;
+      // The inputs are no longer needed
+      for(TH1* h : hists) {
+        delete h;
+      }
+    } // Loop over cross sections
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void Combiner::CombineHists(Parameters& params, std::string spec, int first,
+                              const std::vector<TH1*>& hists,
+                              bool nuflavs, bool parents, bool all,
+                              std::vector<TH1*>& combined)
+  {
+    const int n_flav = params.NFlav();
+    const int n_par  = params.NPar();
+
+    // Combine neutrino flavors with common parent; flavor indices are adjacent
+    if(nuflavs) {
+      for(int i_par = 0; i_par < n_par; ++i_par) {
+        TH1* h = SumHists(hists, n_flav*i_par, 1, n_flav);
+
+        if(h) {
+          h->SetName(CombinedName(params, spec, first + n_flav*i_par, true, false).c_str());
+          combined.push_back(h);
+        }
+      }
     }
 
-    CombineNuFlavs(); // Combine neutrino flavors
-    CombineParents(); // Combine neutrino parents
+    // Combine parents with common neutrino flavor; parent indices are separated by n_flav
+    // These are also the inputs to the full combination
+    std::vector<TH1*> parSums(n_flav, nullptr);
+    if(parents || all) {
+      for(int i_flav = 0; i_flav < n_flav; ++i_flav) {
+        parSums[i_flav] = SumHists(hists, i_flav, n_flav, n_par);
 
-    TDirectory* temp = gDirectory;
+        if(parSums[i_flav]) {
+          parSums[i_flav]->SetName(CombinedName(params, spec, first + i_flav, false, true).c_str());
+        }
+      }
+    }
 
-    for(const std::string& spec: fSpectra) {
-      fOut->cd(spec.c_str());
+    // Combine the combined parent histograms of every flavor, i.e., all neutrinos
+    if(all) {
+      TH1* h = SumHists(parSums, 0, 1, n_flav);
 
-      const unsigned int n_flav = fParamsMap[spec].NFlav();
-      const unsigned int n_par  = fParamsMap[spec].NPar();
-      const unsigned int n_xsec = fParamsMap[spec].NXSec();
-      const unsigned int n_det  = fParamsMap[spec].NDet();
+      if(h) {
+        h->SetName(CombinedName(params, spec, first, true, true).c_str());
+        combined.push_back(h);
+      }
+    }
 
-      for(unsigned int i_det = 0; i_det < n_det; ++i_det) {
-        gDirectory->cd(fParamsMap[spec].GetDetName(i_det).c_str());
+    for(TH1* h : parSums) {
+      if(!h) { continue; }
 
-        for(unsigned int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
-          int index =   n_flav*n_par*n_xsec*i_det
-                      + n_flav*n_par*i_xsec;
+      if(parents) { combined.push_back(h); }
+      else        { delete h; }
+    }
+
+    return;
+  }
 
-          std::string hName = spec + "_" + fParamsMap[spec].NameTag(index);
+  //---------------------------------------------------------------------------
+  TH1* Combiner::SumHists(const std::vector<TH1*>& hists, int index, int step, int n)
+  {
+    TH1* ret = nullptr;
 
-          // Create string for one of the combined Parent histogram names
-          int firstPos = hName.find('_');
-          firstPos = hName.find('_', firstPos+1);
-          int secndPos = hName.find('_', firstPos+1);
-          hName.replace(firstPos+1, secndPos-firstPos-1, par_str);
+    for(int i = 0; i < n; ++i, index += step) {
+      TH1* h = hists[index];
+      if(!h) {
+        continue;
+      }
 
-          // Get the combined parent histogram
-          TH1* h = (TH1*)((TH1*)gDirectory->Get(hName.c_str()))->Clone();
+      if(!ret) {
+        ret = (TH1*)h->Clone(); // Copy the first histogram found into a new histogram for combining
+        ret->SetDirectory(nullptr);
+      }
+      else {
+        ret->Add(h); // Add it into the combined histogram
+      }
+    }
 
-          for(unsigned int i_flav = 1; i_flav < n_flav; ++i_flav) {
-            ++index; // Increment the flavor index
-            hName = spec + "_" + fParamsMap[spec].NameTag(index);
+    return ret;
+  }
 
-            // Make sure the combined parent histogram is the one pulled from the file
-            firstPos = hName.find('_');
-            firstPos = hName.find('_', firstPos+1);
-            secndPos = hName.find('_', firstPos+1);
-            hName.replace(firstPos+1, secndPos-firstPos-1, par_str);
+  //---------------------------------------------------------------------------
+  std::string Combiner::CombinedName(Parameters& params, std::string spec, int index,
+                                     bool allNu, bool allPar)
+  {
+    std::string hName = spec + "_" + params.NameTag(index);
 
-            h->Add((TH1*)gDirectory->Get(hName.c_str()));
-          }
+    // The histogram name has format title_nuflav_par_xsec_det
+    int firstPos = 0, secndPos = 0;
 
-          // The parent name is already replaced by pulling the combined parent histograms
-          // Now replace the neutrino flavor name
-          firstPos = hName.find('_');
-          secndPos = hName.find('_', firstPos+1);
-          hName.replace(firstPos+1, secndPos-firstPos-1, nu_str);
-          h->SetName(hName.c_str());
+    // Replace parent name by "allpar"
+    if(allPar) {
+      firstPos = hName.find('_');
+      firstPos = hName.find('_', firstPos+1); // Update to the next occurence of '_'
+      secndPos = hName.find('_', firstPos+1);
+      hName.replace(firstPos+1, secndPos-firstPos-1, "allpar");
+    }
 
-          gDirectory->WriteTObject(h);
-        } // Loop over cross sections
+    // Replace neutrino flavor name by "allnu"
+    if(allNu) {
+      firstPos = hName.find('_');
+      secndPos = hName.find('_', firstPos+1); // Search only after position specified in second argument
+      hName.replace(firstPos+1, secndPos-firstPos-1, "allnu");
+    }
 
-        fOut->cd(spec.c_str());
-      } // Loop over detectors
+    return hName;
+  }
 
-      fOut->cd();
-    } // Loop over Spectra
+  //---------------------------------------------------------------------------
+  bool Combiner::IsDirectory(TKey* key)
+  {
+    // The class name is stored in the key, so the object itself does not need to be read
+    TClass* cl = TClass::GetClass(key->GetClassName());
 
-    temp->cd();
-    return;
+    return (cl && cl->InheritsFrom(TDirectory::Class()));
   }
 
   //---------------------------------------------------------------------------
@@ -441,4 +598,31 @@ namespace flxrd
 
     return;
   }
+
+  //---------------------------------------------------------------------------
+  void Combiner::SetupParameters(Parameters* params, const SpectraMeta& meta)
+  {
+    params->ClearAll(); // Get rid of all defaults
+
+    params->fSignSensitive = meta.fSignSensitive;
+    params->fAncestorPar   = meta.fAncestorPar;
+
+    // Everything is added in the order it was written, so the master indices match those of the Spectra
+    // The cross sections were validated when the Spectra was made, so the cross section file is not needed
+    for(const auto& flav : meta.fNuFlavs) {
+      params->fNuFlav.push_back(NuFlav(flav.first, flav.second));
+    }
+    for(const auto& par : meta.fParents) {
+      params->fParent.push_back(Parent(par.first, par.second));
+    }
+    params->fXSec = meta.fXSecs;
+
+    // Sizes and positions are not needed to combine histograms
+    for(const auto& det : meta.fDets) {
+      params->fDet.push_back(Detector(det.name, det.target, 0.,0.,0., 0.,0.,0., det.uses));
+    }
+
+    params->UpdateIndices(); // Make sure the Parameters' Indices object is aware of these changes
+    return;
+  }
 }
@@ -0,0 +1,41 @@
+#include "Cut.h"
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  int Cut::NextID()
+  {
+    static int lastID = 0;
+    return ++lastID;
+  }
+
+  //---------------------------------------------------------------------------
+  Cut operator&&(const Cut& a, const Cut& b)
+  {
+    std::set<std::string> branches = a.Branches();
+    branches.insert(b.Branches().begin(), b.Branches().end());
+
+    return Cut(branches,
+               [a, b](const bsim::Dk2Nu* nu)
+               { return a(nu) && b(nu); });
+  }
+
+  //---------------------------------------------------------------------------
+  Cut operator||(const Cut& a, const Cut& b)
+  {
+    std::set<std::string> branches = a.Branches();
+    branches.insert(b.Branches().begin(), b.Branches().end());
+
+    return Cut(branches,
+               [a, b](const bsim::Dk2Nu* nu)
+               { return a(nu) || b(nu); });
+  }
+
+  //---------------------------------------------------------------------------
+  Cut operator!(const Cut& a)
+  {
+    return Cut(a.Branches(),
+               [a](const bsim::Dk2Nu* nu)
+               { return !a(nu); });
+  }
+}
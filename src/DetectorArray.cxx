@@ -0,0 +1,167 @@
+#include "DetectorArray.h"
+
+// C/C++ Includes
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+// Other External Includes
+#include "dk2nu.h"
+#include "calcLocationWeights.h"
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  DetectorArray::DetectorArray(const std::string& name, const std::string& target,
+                               const std::vector<TVector3>& positions)
+    : fName(name), fTarget(target)
+  {
+    assert(!positions.empty()); // The array needs at least one position
+
+    for(const auto& pos : positions) {
+      fX.push_back(pos.X());
+      fY.push_back(pos.Y());
+      fZ.push_back(pos.Z());
+    }
+
+    fEnergy.assign(fX.size(), 0.);
+    fWeight.assign(fX.size(), 0.);
+  }
+
+  //---------------------------------------------------------------------------
+  DetectorArray::DetectorArray(const std::string& name, const std::string& target,
+                               const std::vector<double>& xs, const std::vector<double>& ys,
+                               const double& z)
+    : fName(name), fTarget(target)
+  {
+    assert(!xs.empty() && !ys.empty()); // The grid needs at least one position
+
+    for(const double y : ys) {
+      for(const double x : xs) {
+        fX.push_back(x);
+        fY.push_back(y);
+        fZ.push_back(z);
+      }
+    }
+
+    fEnergy.assign(fX.size(), 0.);
+    fWeight.assign(fX.size(), 0.);
+  }
+
+  //---------------------------------------------------------------------------
+  TVector3 DetectorArray::GetPosition(int i_pos) const
+  {
+    return TVector3(fX[i_pos], fY[i_pos], fZ[i_pos]);
+  }
+
+  //---------------------------------------------------------------------------
+  Detector DetectorArray::GetDetector() const
+  {
+    return Detector(fName, fTarget, fX[0], fY[0], fZ[0], 0., 0., 0., 0);
+  }
+
+  //---------------------------------------------------------------------------
+  bool DetectorArray::SamePositions(const DetectorArray& otherArray) const
+  {
+    return (!fTarget.compare(otherArray.fTarget) &&
+            fX == otherArray.fX && fY == otherArray.fY && fZ == otherArray.fZ);
+  }
+
+  //---------------------------------------------------------------------------
+  void DetectorArray::Reweight(const bsim::Dk2Nu* nu)
+  {
+    const bsim::Decay& decay = nu->decay;
+    const int n_pos = fX.size();
+
+    // Parent masses (GeV), with the same values as bsim::calcEnuWgt
+    double mass = 0.;
+    switch(std::abs(decay.ptype)) {
+      case 211:  mass = 0.13957; break; // pi+-
+      case 321:  mass = 0.49368; break; // K+-
+      case 130:
+      case 310:
+      case 311:  mass = 0.49767; break; // K0
+      case 3334: mass = 1.67245; break; // Omega-+
+      default:   mass = 0.;      break;
+    }
+
+    // Muon decays need a polarization correction that depends on the position,
+    // and bsim::calcEnuWgt reports unknown parents, so leave both to it
+    if(mass == 0.) {
+      for(int i_pos = 0; i_pos < n_pos; ++i_pos) {
+        bsim::calcEnuWgt(nu, GetPosition(i_pos), fEnergy[i_pos], fWeight[i_pos]);
+      }
+
+      return;
+    }
+
+    // Everything about the parent is shared by all of the positions
+    const double px = decay.pdpx;
+    const double py = decay.pdpy;
+    const double pz = decay.pdpz;
+    const double vx = decay.vx;
+    const double vy = decay.vy;
+    const double vz = decay.vz;
+
+    const double p2    = px*px + py*py + pz*pz;
+    const double p     = std::sqrt(p2);
+    const double gamma = std::sqrt(p2 + mass*mass)/mass;
+    const double beta  = p/(gamma*mass);
+
+    // A parent that has stopped has no boost; its direction term is then 0
+    const double inv_p = (p > 0. ? 1./p : 0.);
+
+    const double necm = decay.necm;
+
+    // The weight is the solid angle fraction of a 100 cm radius circle, times the boost factor squared
+    // The solid angle 1 - cos(atan(R/d)) is written as R^2/(s*(s + d)), with s^2 = d^2 + R^2,
+    // which needs no trigonometric functions and keeps its precision far from the decay
+    const double kRDet2 = 100.*100.;
+
+    // Each position only depends on its own coordinates, so the compiler can vectorize this loop
+    const double* x = &fX[0];
+    const double* y = &fY[0];
+    const double* z = &fZ[0];
+    double* energy = &fEnergy[0];
+    double* weight = &fWeight[0];
+    for(int i_pos = 0; i_pos < n_pos; ++i_pos) {
+      const double dx = x[i_pos] - vx;
+      const double dy = y[i_pos] - vy;
+      const double dz = z[i_pos] - vz;
+
+      const double d2 = dx*dx + dy*dy + dz*dz;
+      const double d  = std::sqrt(d2);
+
+      double costh = (px*dx + py*dy + pz*dz)*inv_p/d;
+      costh = std::min(1., std::max(-1., costh));
+
+      const double emrat = 1./(gamma*(1. - beta*costh));
+
+      const double s = std::sqrt(d2 + kRDet2);
+      const double sangdet = kRDet2/(2.*s*(s + d));
+
+      energy[i_pos] = emrat*necm;
+      weight[i_pos] = sangdet*emrat*emrat;
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void DetectorArray::PrintAll() const
+  {
+    std::cout << "--------------------" << std::endl
+              << "Detector array name: " << fName   << std::endl
+              << "Nuclear target: "      << fTarget << std::endl
+              << "Positions: " << fX.size() << std::endl;
+
+    for(unsigned int i_pos = 0, n_pos = fX.size(); i_pos < n_pos; ++i_pos) {
+      std::cout << "  " << i_pos << ": (" << fX[i_pos] << ", " << fY[i_pos] << ", " << fZ[i_pos] << ")" << std::endl;
+    }
+
+    std::cout << "--------------------" << std::endl;
+
+    return;
+  }
+}
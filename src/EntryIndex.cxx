@@ -0,0 +1,265 @@
+#include "EntryIndex.h"
+
+// C/C++ Includes
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+// Root Includes
+#include "TEntryList.h"
+#include "TFile.h"
+#include "TObjString.h"
+#include "TSystem.h"
+#include "TTree.h"
+
+// Other External Includes
+#include "dk2nu.h"
+
+namespace flxrd
+{
+  namespace
+  {
+    /// Name of the description of the index in the sidecar file
+    const char* kKeyName = "EntryIndexKey";
+  }
+
+  //---------------------------------------------------------------------------
+  bool EntryIndex::Read(const std::string& indexPath, const std::string& fileName)
+  {
+    Long64_t size = 0;
+    Long_t modTime = 0;
+    if(!FileStamp(fileName, size, modTime) || gSystem->AccessPathName(indexPath.c_str())) {
+      return false;
+    }
+
+    TFile* f = TFile::Open(indexPath.c_str(), "READ");
+    if(!f || f->IsZombie()) {
+      delete f;
+      return false;
+    }
+
+    TObjString* key = dynamic_cast<TObjString*>(f->Get(kKeyName));
+    if(!key) {
+      f->Close();
+      delete f;
+      return false;
+    }
+
+    // The description has one line per field, with a key followed by its values, all separated by tabs,
+    // followed by one line per entry list with its family, flavor, and ancestor
+    int version = 0;
+    std::string file = "";
+    Long64_t fileSize = -1;
+    Long_t fileTime = -1;
+    std::vector<std::pair<bool, std::pair<int, int> > > lists;
+
+    std::istringstream in(key->GetString().Data());
+    std::string line;
+    while(std::getline(in, line)) {
+      std::vector<std::string> fields;
+      std::istringstream lineStream(line);
+      std::string field;
+      while(std::getline(lineStream, field, '\t')) {
+        fields.push_back(field);
+      }
+
+      if(fields.size() < 2) { continue; }
+
+      const std::string& name = fields[0];
+
+      if     (!name.compare("version")) { version   = std::atoi (fields[1].c_str()); }
+      else if(!name.compare("file"   )) { file      = fields[1]; }
+      else if(!name.compare("size"   )) { fileSize  = std::atoll(fields[1].c_str()); }
+      else if(!name.compare("mtime"  )) { fileTime  = std::atol (fields[1].c_str()); }
+      else if(!name.compare("entries")) { fNEntries = std::atoll(fields[1].c_str()); }
+      else if((!name.compare("par") || !name.compare("tgt")) && fields.size() == 3) {
+        lists.push_back(std::make_pair(!name.compare("par"),
+                                       std::make_pair(std::atoi(fields[1].c_str()), std::atoi(fields[2].c_str()))));
+      }
+    }
+    delete key;
+
+    // The flux file must be the same one that was indexed
+    bool ok = (version == kVersion && !file.compare(fileName) && fileSize == size && fileTime == modTime);
+
+    fParEntries.clear();
+    fTgtEntries.clear();
+
+    for(unsigned int i_list = 0, n_list = lists.size(); i_list < n_list && ok; ++i_list) {
+      const bool ancestorPar = lists[i_list].first;
+      const std::pair<int, int>& pdgs = lists[i_list].second;
+
+      TEntryList* list = dynamic_cast<TEntryList*>(f->Get(ListName(ancestorPar, pdgs.first, pdgs.second).c_str()));
+      if(!list) {
+        ok = false;
+        break;
+      }
+
+      std::vector<Long64_t>& entries = (ancestorPar ? fParEntries : fTgtEntries)[pdgs];
+      entries.reserve(list->GetN());
+
+      // Sequential access is much faster than looking each entry up by index
+      if(list->GetN() > 0) {
+        entries.push_back(list->GetEntry(0));
+        for(Long64_t i_entry = 1, n_entry = list->GetN(); i_entry < n_entry; ++i_entry) {
+          entries.push_back(list->Next());
+        }
+      }
+
+      delete list;
+    }
+
+    f->Close();
+    delete f;
+
+    if(ok) {
+      fFileName = fileName;
+      fFileSize = size;
+      fModTime  = modTime;
+    }
+    else {
+      fParEntries.clear();
+      fTgtEntries.clear();
+      fNEntries = 0;
+    }
+
+    return ok;
+  }
+
+  //---------------------------------------------------------------------------
+  bool EntryIndex::Build(const std::string& fileName, const std::string& treePath)
+  {
+    if(!FileStamp(fileName, fFileSize, fModTime)) {
+      return false;
+    }
+
+    TFile* f = TFile::Open(fileName.c_str(), "READ");
+    if(!f || f->IsZombie()) {
+      delete f;
+      return false;
+    }
+
+    TTree* tree = dynamic_cast<TTree*>(f->Get(treePath.c_str()));
+    if(!tree) {
+      std::cout << fileName << " has no tree " << treePath << " to index." << std::endl;
+      f->Close();
+      delete f;
+      return false;
+    }
+
+    // Only read the branches the index is grouped by
+    tree->SetBranchStatus("*", 0);
+    tree->SetBranchStatus("decay", 1);
+    tree->SetBranchStatus("decay.ntype", 1);
+    tree->SetBranchStatus("decay.ptype", 1);
+    tree->SetBranchStatus("tgtexit", 1);
+    tree->SetBranchStatus("tgtexit.tptype", 1);
+
+    bsim::Dk2Nu* nu = nullptr;
+    tree->SetBranchAddress("dk2nu", &nu);
+
+    fFileName = fileName;
+    fNEntries = tree->GetEntries();
+    fParEntries.clear();
+    fTgtEntries.clear();
+
+    for(Long64_t i_entry = 0; i_entry < fNEntries; ++i_entry) {
+      tree->GetEntry(i_entry);
+
+      fParEntries[std::make_pair(nu->decay.ntype, nu->decay.ptype   )].push_back(i_entry);
+      fTgtEntries[std::make_pair(nu->decay.ntype, nu->tgtexit.tptype)].push_back(i_entry);
+    }
+
+    tree->ResetBranchAddresses();
+    delete nu;
+
+    f->Close();
+    delete f;
+
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  bool EntryIndex::Write(const std::string& indexPath) const
+  {
+    // Write a file private to this process, and move it into place in one step,
+    // so jobs indexing the same file at once never see (or leave) a partial index
+    std::string tempPath = indexPath + ".tmp" + std::to_string(gSystem->GetPid());
+
+    TFile* f = TFile::Open(tempPath.c_str(), "RECREATE");
+    if(!f || f->IsZombie()) {
+      std::cout << "Could not write the entry index " << indexPath << "." << std::endl;
+      delete f;
+      gSystem->Unlink(tempPath.c_str());
+      return false;
+    }
+
+    std::ostringstream out;
+    out << "version\t" << kVersion  << '\n';
+    out << "file\t"    << fFileName << '\n';
+    out << "size\t"    << fFileSize << '\n';
+    out << "mtime\t"   << fModTime  << '\n';
+    out << "entries\t" << fNEntries << '\n';
+
+    for(int i_family = 0; i_family < 2; ++i_family) {
+      const bool ancestorPar = (i_family == 0);
+
+      for(const auto& group : (ancestorPar ? fParEntries : fTgtEntries)) {
+        out << (ancestorPar ? "par" : "tgt") << '\t' << group.first.first << '\t' << group.first.second << '\n';
+
+        std::string name = ListName(ancestorPar, group.first.first, group.first.second);
+        TEntryList list(name.c_str(), name.c_str());
+        for(const Long64_t entry : group.second) {
+          list.Enter(entry);
+        }
+
+        f->WriteTObject(&list);
+      }
+    }
+
+    TObjString key(out.str().c_str());
+    const bool written = (f->WriteTObject(&key, kKeyName) > 0);
+
+    f->Close();
+    delete f;
+
+    if(!written || std::rename(tempPath.c_str(), indexPath.c_str()) != 0) {
+      std::cout << "Could not write the entry index " << indexPath << "." << std::endl;
+      gSystem->Unlink(tempPath.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  void EntryIndex::AddEntries(bool ancestorPar, const std::function<SelectFunc_t>& select,
+                              Long64_t offset, std::vector<Long64_t>& entries) const
+  {
+    for(const auto& group : (ancestorPar ? fParEntries : fTgtEntries)) {
+      if(!select(group.first.first, group.first.second)) {
+        continue;
+      }
+
+      for(const Long64_t entry : group.second) {
+        entries.push_back(entry + offset);
+      }
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  bool EntryIndex::FileStamp(const std::string& fileName, Long64_t& size, Long_t& modTime)
+  {
+    Long_t id = 0, flags = 0;
+    return gSystem->GetPathInfo(fileName.c_str(), &id, &size, &flags, &modTime) == 0;
+  }
+
+  //---------------------------------------------------------------------------
+  std::string EntryIndex::ListName(bool ancestorPar, int nuPDG, int ancestorPDG)
+  {
+    return (ancestorPar ? "par_" : "tgt_") + std::to_string(nuPDG) + "_" + std::to_string(ancestorPDG);
+  }
+}
@@ -1,8 +1,10 @@
 #include "FluxReader.h"
 
 // C/C++ Includes
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <set>
 #include <utility>
 
 // Root Includes
@@ -19,11 +21,13 @@
 
 // Package Includes
 #include "Detector.h"
+#include "EntryIndex.h"
 #include "Spectra.h"
-#include "Spectra1D.h"
-#include "Spectra2D.h"
-#include "Spectra3D.h"
 #include "SpectraCorrDet.h"
+#include "SpectraMeta.h"
+#include "SpectraArray.h"
+#include "SpectraND.h"
+#include "SpectraUniverse.h"
 #include "Utilities.h"
 
 // Other External Includes
@@ -79,6 +83,12 @@ namespace flxrd
 
     fReweightNuRay = false; // By default, turn this off for speed
 
+    fWriteEmptyHists = false; // By default, only write histograms that were filled
+
+    fCombineHists = false; // By default, leave combining to the Combiner
+
+    fUseEntryIndex = false; // By default, visit every entry
+
     fTreePath = "dk2nuTree";  // This is the default tree name in Dk2Nu files
     fMetaPath = "dkmetaTree"; // This is the default metadata tree name in Dk2Nu files
     fPOTPath  = "pots";       // This is the default POT variable name in Dk2Nu files
@@ -111,13 +121,69 @@ namespace flxrd
 
     SetBranches(fluxChain, metaChain); // Turn on the necessary branches
 
+    // Point each SpectraArray to the array that is reweighted for it
+    for(const auto& spectra : fSpectra) {
+      SpectraArray* s = dynamic_cast<SpectraArray*>(spectra);
+      if(!s) {
+        continue;
+      }
+
+      for(const auto& array : fArrays) {
+        if(!array.GetName().compare(s->fArray.GetName())) {
+          s->fRays = &array;
+        }
+      }
+    }
+
+    // Give each Spectra that can fill replicas the bootstrap weights
+    if(fBootstrap.NReplicas() > 0) {
+      // Files with the same name (e.g., in per run directories) would get the same replica weights,
+      // so their replicas would be fully correlated; in that case, every file is keyed by its full path
+      for(const bool fullPath : {false, true}) {
+        fFileKeys.clear();
+        std::set<uint64_t> keys;
+        for(const auto& fileName : fInputFiles) {
+          fFileKeys.push_back(Bootstrap::FileKey(fileName, fullPath));
+          keys.insert(fFileKeys.back());
+        }
+
+        if(keys.size() == fFileKeys.size()) {
+          break;
+        }
+
+        if(!fullPath) {
+          std::cout << "Warning: some input files share a name. "
+                    << "The bootstrap replicas are keyed by the full path of each file instead, "
+                    << "so they change if the files are moved." << std::endl;
+        }
+        else {
+          std::cerr << "An input file is listed more than once, so its replicas would be counted twice. "
+                    << "Asserting 0." << std::endl;
+          assert(0);
+        }
+      }
+
+      for(const auto& spectra : fSpectra) {
+        if(spectra->CanBootstrap()) {
+          spectra->fBootstrap = &fBootstrap;
+        }
+        else {
+          std::cout << "Spectra " << spectra->GetTitle() << " does not fill bootstrap replicas." << std::endl;
+        }
+      }
+    }
+
     std::cout << "BEGIN!" << std::endl;
     std::cout << "--------------------------------------------------" << std::endl << std::endl;
 
     int totEntries = 0;  // Total entries over all input files
+    int cutEntries = 0;  // Entries selected by no Spectra
     double totPOT  = 0.; // Sum of POT found in each file (an int is too small to store this number)
     int treeNumber = -1; // Store the tree number corresponding to the previous entry
 
+    // Bytes read in each stage, and the size of the active branches, which is what reading every entry would take
+    double selectBytes = 0., payloadBytes = 0., activeBytes = 0.;
+
     unsigned int i_entry = 0;
     while(metaChain->GetEntry(i_entry)) {
       ++i_entry;
@@ -125,9 +191,19 @@ namespace flxrd
       totPOT += fMeta->pots;
     }
 
+    // With the index, only visit the entries that some Spectra could select by flavor and parent
+    std::vector<Long64_t> indexed;
+    const bool useIndex = fUseEntryIndex && IndexEntries(fluxChain, indexed);
+    unsigned int i_indexed = 0;
+
     i_entry = 0; // Reset the entry number to 0
-    while(fluxChain->GetEntry(i_entry)) {
-      ++i_entry;
+    while(!useIndex || i_indexed < indexed.size()) {
+      const Long64_t i_chain = (useIndex ? indexed[i_indexed++] : i_entry++);
+
+      Long64_t treeEntry = fluxChain->LoadTree(i_chain); // Entry number inside the current tree
+      if(treeEntry < 0) {
+        break;
+      }
 
       // Let the user know where things stand periodically
       ++totEntries;
@@ -136,9 +212,27 @@ namespace flxrd
       }
 
       // Let the user know when moving to a new tree, i.e., a new file
+      // Each tree has its own TBranches
       if(treeNumber != fluxChain->GetTreeNumber()) {
         treeNumber = fluxChain->GetTreeNumber();
         std::cout << "Moving to tree number " << treeNumber << "." << std::endl;
+
+        activeBytes += LoadStageBranches(fluxChain->GetTree());
+      }
+
+      // Read the branches that decide whether any Spectra selects this entry,
+      // and skip the rest of the work (including reading the other branches) if none does
+      selectBytes += ReadBranches(fSelectBranches, treeEntry);
+
+      if(!SelectEntry()) {
+        ++cutEntries;
+        continue;
+      }
+
+      payloadBytes += ReadBranches(fPayloadBranches, treeEntry);
+
+      if(fBootstrap.NReplicas() > 0) {
+        fBootstrap.SetEntry(fFileKeys[treeNumber], treeEntry);
       }
 
       // Only the NuRay energy and weight change by detector,
@@ -157,8 +251,10 @@ namespace flxrd
             fNu->nuray[index].wgt = propwt; // Store the new weight
           }
           else { // Same as above, but perform the calculation for each use at once
+            fSmearSampler.NewRay(det.GetUses()); // Choose the points of all of the uses together
+
             for(int i_use = 0, n_use = det.GetUses(); i_use < n_use; ++i_use) {
-              TVector3 xyz = Smear(det); // Smear the ray through the detector
+              TVector3 xyz = Smear(det, i_use); // Smear the ray through the detector
               ToBeamCoords(det, xyz);
               bsim::calcEnuWgt(fNu, xyz, energy, propwt);
               fNu->nuray[index + i_use].E = energy;
@@ -166,11 +262,21 @@ namespace flxrd
             }
           } // end of conditionals if detector uses is 1
         } // end of loop over detectors
+
+        // Every position of an array is reweighted at once
+        for(auto& array : fArrays) {
+          array.Reweight(fNu);
+        }
       } // end of conditional if NuRay needs to be reweighted
 
-      // Fill histograms with values read from the entry
-      for(const auto& spectra : fSpectra) {
-        spectra->Fill(fNu, fNuRayIndex);
+      // Fill histograms with values read from the entry, if it passes the Spectra's Cut
+      for(int i_spec = 0, n_spec = fSpectra.size(); i_spec < n_spec; ++i_spec) {
+        const int i_cut = fSpectraCuts[i_spec];
+        if(i_cut >= 0 && !fCutPass[i_cut]) {
+          continue;
+        }
+
+        fSpectra[i_spec]->Fill(fNu, fNuRayIndex);
       }
 
     } // end of loop over flux tree entries
@@ -181,6 +287,16 @@ namespace flxrd
     std::cout << "--------------------------------------------------" << std::endl;
     std::cout << "Total POT: " << totPOT << std::endl;
     std::cout << "Number of entries: " << totEntries << std::endl;
+    if(useIndex) {
+      std::cout << "(Only entries with a selected flavor and parent were visited, using the entry index)" << std::endl;
+    }
+    std::cout << "Entries selected by no Spectra: " << cutEntries << std::endl;
+    if(activeBytes > 0.) {
+      // These are uncompressed bytes; a tree cache may still read some of the skipped baskets from disk
+      std::cout << "Bytes read: " << selectBytes << " for selection, " << payloadBytes << " for payload, "
+                << "of " << activeBytes << " in the active branches ("
+                << 100.*(1. - (selectBytes + payloadBytes)/activeBytes) << "% saved)" << std::endl;
+    }
 
     // Create total POT histogram
     TH1D* hPOT = new TH1D("TotalPOT", ";;POT", 1, 0., 1.);
@@ -192,7 +308,14 @@ namespace flxrd
     for(const auto& spectra : fSpectra) {
       out->mkdir(spectra->GetTitle().c_str()); // Create directory in output file
       out->cd(spectra->GetTitle().c_str()); // Go to the new directory
+      spectra->fWriteEmpty = fWriteEmptyHists;
+      spectra->fCombine    = fCombineHists;
       spectra->WriteHists(gDirectory); // Have Spectra object write out its contents
+
+      // Describe the Spectra next to its histograms, so its Parameters do not need to be parsed from names
+      SpectraMeta meta = spectra->MakeMeta();
+      meta.fPOT = totPOT;
+      meta.Write(out->GetDirectory(spectra->GetTitle().c_str()));
     }
 
     temp->cd(); // Return to the original directory
@@ -204,14 +327,17 @@ namespace flxrd
                               std::string labelx, std::vector<double> binsx, const Var& varx,
                               const Weight& wei, TObject* extWeights)
   {
-    // Create the new Spectra1D object
-    Spectra1D* s = new Spectra1D(params, title,
-                                 labelx, binsx, varx,
-                                 wei, extWeights);
-    fSpectra.push_back(s); // Add it to the vector of Spectra
-
-    AddBranches(s->BranchesToAdd()); // Add necessary branches to master list
+    AddSpectra(params, title, labelx, binsx, varx, kNoCut, wei, extWeights);
+    return;
+  }
 
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              std::string labely, std::vector<double> binsy, const Var& vary,
+                              const Weight& wei, TObject* extWeights)
+  {
+    AddSpectra(params, title, labelx, binsx, varx, labely, binsy, vary, kNoCut, wei, extWeights);
     return;
   }
 
@@ -219,17 +345,91 @@ namespace flxrd
   void FluxReader::AddSpectra(Parameters params, std::string title,
                               std::string labelx, std::vector<double> binsx, const Var& varx,
                               std::string labely, std::vector<double> binsy, const Var& vary,
+                              std::string labelz, std::vector<double> binsz, const Var& varz,
                               const Weight& wei, TObject* extWeights)
   {
-    // Create the new Spectra2D object
-    Spectra2D* s = new Spectra2D(params, title,
-                                 labelx, binsx, varx, 
-                                 labely, binsy, vary,
-                                 wei, extWeights);
-    fSpectra.push_back(s);
+    AddSpectra(params, title, labelx, binsx, varx, labely, binsy, vary, labelz, binsz, varz,
+               kNoCut, wei, extWeights);
+    return;
+  }
 
-    AddBranches(s->BranchesToAdd()); // Add necessary branches to master list
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::vector<std::string> labels,
+                              std::vector<std::vector<double> > bins,
+                              std::vector<Var> vars,
+                              const Weight& wei, TObject* extWeights)
+  {
+    AddSpectra(params, title, labels, bins, vars, kNoCut, wei, extWeights);
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::string detX, std::string detY,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              const Weight& wei, TObject* extWeights)
+  {
+    AddSpectra(params, title, detX, detY, labelx, binsx, varx, kNoCut, wei, extWeights);
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::vector<std::string> dets,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              const Weight& wei, TObject* extWeights)
+  {
+    AddSpectra(params, title, dets, labelx, binsx, varx, kNoCut, wei, extWeights);
+    return;
+  }
 
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              const UniverseWeight& univWei,
+                              const Weight& wei, TObject* extWeights)
+  {
+    AddSpectra(params, title, labelx, binsx, varx, univWei, kNoCut, wei, extWeights);
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              const DetectorArray& array,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              const Weight& wei, TObject* extWeights)
+  {
+    AddSpectra(params, title, array, labelx, binsx, varx, kNoCut, wei, extWeights);
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              const Cut& cut,
+                              const Weight& wei, TObject* extWeights)
+  {
+    AddSpectra(params, title,
+               std::vector<std::string>{labelx},
+               std::vector<std::vector<double> >{binsx},
+               std::vector<Var>{varx},
+               cut, wei, extWeights);
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              std::string labely, std::vector<double> binsy, const Var& vary,
+                              const Cut& cut,
+                              const Weight& wei, TObject* extWeights)
+  {
+    AddSpectra(params, title,
+               std::vector<std::string>{labelx, labely},
+               std::vector<std::vector<double> >{binsx, binsy},
+               std::vector<Var>{varx, vary},
+               cut, wei, extWeights);
     return;
   }
 
@@ -238,17 +438,45 @@ namespace flxrd
                               std::string labelx, std::vector<double> binsx, const Var& varx,
                               std::string labely, std::vector<double> binsy, const Var& vary,
                               std::string labelz, std::vector<double> binsz, const Var& varz,
+                              const Cut& cut,
                               const Weight& wei, TObject* extWeights)
   {
-    // Create the new Spectra3D object
-    Spectra3D* s = new Spectra3D(params, title,
-                                 labelx, binsx, varx,
-                                 labely, binsy, vary,
-                                 labelz, binsz, varz,
-                                 wei, extWeights);
-    fSpectra.push_back(s);
+    AddSpectra(params, title,
+               std::vector<std::string>{labelx, labely, labelz},
+               std::vector<std::vector<double> >{binsx, binsy, binsz},
+               std::vector<Var>{varx, vary, varz},
+               cut, wei, extWeights);
+    return;
+  }
 
-    AddBranches(s->BranchesToAdd()); // Add necessary branches to master list
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::vector<std::string> labels,
+                              std::vector<std::vector<double> > bins,
+                              std::vector<Var> vars,
+                              const Cut& cut,
+                              const Weight& wei, TObject* extWeights)
+  {
+    if(labels.size() != vars.size() || bins.size() != vars.size()) {
+      std::cout << "Each axis needs a label, bin edges, and a Var." << std::endl;
+      assert(false);
+    }
+
+    // Create the new SpectraND object with the matching dimension
+    Spectra* s = nullptr;
+    switch(vars.size()) {
+      case 1: s = new SpectraND<1>(params, title, labels, bins, vars, wei, extWeights); break;
+      case 2: s = new SpectraND<2>(params, title, labels, bins, vars, wei, extWeights); break;
+      case 3: s = new SpectraND<3>(params, title, labels, bins, vars, wei, extWeights); break;
+      case 4: s = new SpectraND<4>(params, title, labels, bins, vars, wei, extWeights); break;
+      case 5: s = new SpectraND<5>(params, title, labels, bins, vars, wei, extWeights); break;
+      case 6: s = new SpectraND<6>(params, title, labels, bins, vars, wei, extWeights); break;
+      default:
+        std::cout << "Spectra can have between 1 and 6 dimensions." << std::endl;
+        assert(false);
+    }
+
+    StoreSpectra(s, cut);
 
     return;
   }
@@ -257,6 +485,7 @@ namespace flxrd
   void FluxReader::AddSpectra(Parameters params, std::string title,
                               std::string detX, std::string detY,
                               std::string labelx, std::vector<double> binsx, const Var& varx,
+                              const Cut& cut,
                               const Weight& wei, TObject* extWeights)
   {
     // Create the new SpectraCorrDet object
@@ -264,9 +493,72 @@ namespace flxrd
                                            detX, detY,
                                            labelx, binsx, varx,
                                            wei, extWeights);
-    fSpectra.push_back(s);
+    StoreSpectra(s, cut);
 
-    AddBranches(s->BranchesToAdd()); // Add necessary branches to master list
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::vector<std::string> dets,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              const Cut& cut,
+                              const Weight& wei, TObject* extWeights)
+  {
+    // Create the new SpectraCorrDet object, correlating every pair of detectors
+    SpectraCorrDet* s = new SpectraCorrDet(params, title,
+                                           dets,
+                                           labelx, binsx, varx,
+                                           wei, extWeights);
+    StoreSpectra(s, cut);
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              const UniverseWeight& univWei, const Cut& cut,
+                              const Weight& wei, TObject* extWeights)
+  {
+    // Create the new SpectraUniverse object
+    SpectraUniverse* s = new SpectraUniverse(params, title,
+                                             labelx, binsx, varx,
+                                             univWei,
+                                             wei, extWeights);
+    StoreSpectra(s, cut);
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::AddSpectra(Parameters params, std::string title,
+                              const DetectorArray& array,
+                              std::string labelx, std::vector<double> binsx, const Var& varx,
+                              const Cut& cut,
+                              const Weight& wei, TObject* extWeights)
+  {
+    // Spectra share an array by name, so the same name must always mean the same target and positions
+    bool found = false;
+    for(const auto& other : fArrays) {
+      if(!other.GetName().compare(array.GetName())) {
+        if(!other.SamePositions(array)) {
+          std::cerr << "Detector array " << array.GetName()
+                    << " was already added with a different target or positions. Asserting 0." << std::endl;
+          assert(0);
+        }
+        found = true;
+      }
+    }
+    if(!found) {
+      fArrays.push_back(array);
+    }
+
+    // Create the new SpectraArray object
+    SpectraArray* s = new SpectraArray(params, title, array,
+                                       labelx, binsx, varx,
+                                       wei, extWeights);
+    StoreSpectra(s, cut);
 
     return;
   }
@@ -299,6 +591,42 @@ namespace flxrd
     return;
   }
 
+  //---------------------------------------------------------------------------
+  void FluxReader::SetWriteEmptyHists(bool writeEmpty)
+  {
+    fWriteEmptyHists = writeEmpty;
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::UseEntryIndex(std::string indexDir)
+  {
+    fUseEntryIndex = true;
+    fIndexDir = indexDir;
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::SetCombineHists(bool combine)
+  {
+    fCombineHists = combine;
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::SetBootstrap(int nReplicas, unsigned long long seed)
+  {
+    fBootstrap = Bootstrap(nReplicas, seed);
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::SetSmearMode(SmearSampler::Mode mode)
+  {
+    fSmearSampler = SmearSampler(mode);
+    return;
+  }
+
   //---------------------------------------------------------------------------
   void FluxReader::AddBranch(std::string branchName)
   {
@@ -347,6 +675,219 @@ namespace flxrd
     return;
   }
 
+  //---------------------------------------------------------------------------
+  void FluxReader::StoreSpectra(Spectra* s, const Cut& cut)
+  {
+    fSpectra.push_back(s); // Add it to the vector of Spectra
+
+    AddBranches(s->BranchesToAdd()); // Add necessary branches to master list
+
+    // These are needed to check the neutrino flavor and parent against the Spectra's Parameters
+    fSelectBranchNames.insert("decay.ntype");
+    fSelectBranchNames.insert(s->fParams.GetAncestorPar() ? "decay.ptype" : "tgtexit.tptype");
+
+    if(cut.ID() == 0) { // The Spectra selects every entry
+      fSpectraCuts.push_back(-1);
+      return;
+    }
+
+    // Copies of a Cut share its identifier, so a Cut used by several Spectra is only stored once
+    int i_cut = 0;
+    const int n_cut = fCuts.size();
+    while(i_cut < n_cut && fCuts[i_cut].ID() != cut.ID()) {
+      ++i_cut;
+    }
+
+    if(i_cut == n_cut) {
+      fCuts.push_back(cut);
+      fCutPass.push_back(0);
+      AddBranches(cut.Branches());
+      fSelectBranchNames.insert(cut.Branches().begin(), cut.Branches().end());
+    }
+
+    fSpectraCuts.push_back(i_cut);
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  bool FluxReader::SelectEntry()
+  {
+    for(int i_cut = 0, n_cut = fCuts.size(); i_cut < n_cut; ++i_cut) {
+      fCutPass[i_cut] = fCuts[i_cut](fNu);
+    }
+
+    for(int i_spec = 0, n_spec = fSpectra.size(); i_spec < n_spec; ++i_spec) {
+      const int i_cut = fSpectraCuts[i_spec];
+      if((i_cut < 0 || fCutPass[i_cut]) && fSpectra[i_spec]->SetCurrentEntry(fNu)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  //---------------------------------------------------------------------------
+  void FluxReader::SplitBranches()
+  {
+    fSelectPaths .clear();
+    fPayloadPaths.clear();
+
+    for(const std::string& branch : fBranchNames) {
+      // Reading a branch also reads its active sub-branches, so only read those without any
+      // (the count of a split vector is read by its sub-branches as needed)
+      bool hasSub = false;
+      for(const std::string& other : fBranchNames) {
+        hasSub = hasSub || !other.compare(0, branch.length() + 1, branch + ".");
+      }
+      if(hasSub) { continue; }
+
+      if(fSelectBranchNames.find(branch) != fSelectBranchNames.end()) {
+        fSelectPaths.push_back(fBranchPaths[branch]);
+      }
+      else {
+        fPayloadPaths.push_back(fBranchPaths[branch]);
+      }
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  double FluxReader::LoadStageBranches(TTree* fluxTree)
+  {
+    double totBytes = 0.;
+
+    fSelectBranches .clear();
+    fPayloadBranches.clear();
+
+    for(int i_stage = 0; i_stage < 2; ++i_stage) {
+      const std::vector<std::string>& paths    = (i_stage == 0 ? fSelectPaths    : fPayloadPaths);
+      std::vector<TBranch*>&           branches = (i_stage == 0 ? fSelectBranches : fPayloadBranches);
+
+      for(const std::string& path : paths) {
+        branches.push_back(fluxTree->GetBranch(path.c_str()));
+        if(!branches.back()) {
+          std::cerr << "Tree has no branch \"" << path
+                    << "\". Asserting 0." << std::endl;
+          assert(0);
+        }
+
+        totBytes += branches.back()->GetTotBytes();
+      }
+    }
+
+    return totBytes;
+  }
+
+  //---------------------------------------------------------------------------
+  bool FluxReader::IndexEntries(TChain* chain, std::vector<Long64_t>& entries)
+  {
+    if(!IsStandardDk2Nu()) {
+      std::cout << "Only standard Dk2Nu files can be indexed. Visiting every entry." << std::endl;
+      return false;
+    }
+
+    entries.clear();
+
+    Long64_t offset = 0; // Chain entry number of the first entry of the current file
+
+    const Long64_t* treeOffsets = nullptr; // First chain entry of each tree, only found if a file cannot be indexed
+
+    for(unsigned int i_file = 0, n_file = fInputFiles.size(); i_file < n_file; ++i_file) {
+      const std::string& fileName = fInputFiles[i_file];
+      EntryIndex index;
+
+      if(!index.Read(IndexPath(fileName), fileName)) {
+        std::cout << "Indexing " << fileName << "." << std::endl;
+        if(!index.Build(fileName, fTreePath)) {
+          // Every entry of this file is visited, and the other files still use their indices
+          // Each input file is its own tree of the chain, in the same order
+          if(!treeOffsets) {
+            chain->GetEntries(); // Open every tree, so the offsets are known
+            treeOffsets = chain->GetTreeOffset();
+          }
+
+          const Long64_t n_entries = treeOffsets[i_file + 1] - treeOffsets[i_file];
+          std::cout << "Could not index " << fileName << ". Visiting its " << n_entries << " entries." << std::endl;
+
+          for(Long64_t i_entry = 0; i_entry < n_entries; ++i_entry) {
+            entries.push_back(offset + i_entry);
+          }
+
+          offset += n_entries;
+          continue;
+        }
+
+        index.Write(IndexPath(fileName)); // Without the file, the index is just rebuilt next time
+      }
+
+      // An entry is needed if any Spectra includes its flavor and ancestor
+      for(int i_anc = 0; i_anc < 2; ++i_anc) {
+        const bool ancestorPar = (i_anc == 0);
+
+        std::vector<Spectra*> spectra;
+        for(const auto& s : fSpectra) {
+          if(s->fParams.GetAncestorPar() == ancestorPar) {
+            spectra.push_back(s);
+          }
+        }
+
+        if(spectra.empty()) { continue; }
+
+        index.AddEntries(ancestorPar,
+                         [&spectra](int nuPDG, int ancestorPDG)
+                         { for(const auto& s : spectra) {
+                             if(s->SetCurrentEntry(nuPDG, ancestorPDG)) {
+                               return true;
+                             }
+                           }
+                           return false; },
+                         offset, entries);
+      }
+
+      offset += index.NEntries();
+    }
+
+    // Entries selected through both ancestor types are listed twice, and the chain must be read in order
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    std::cout << "The entry index selects " << entries.size() << " of " << offset << " entries." << std::endl;
+
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  std::string FluxReader::IndexPath(const std::string& fileName) const
+  {
+    if(fIndexDir.empty()) {
+      return fileName + ".index.root";
+    }
+
+    // Flatten the full path into the file name, so input files with the same name do not collide
+    std::string flat = fileName;
+    for(auto& c : flat) {
+      if(c == '/') {
+        c = '_';
+      }
+    }
+
+    return fIndexDir + "/" + flat + ".index.root";
+  }
+
+  //---------------------------------------------------------------------------
+  int FluxReader::ReadBranches(const std::vector<TBranch*>& branches, Long64_t treeEntry)
+  {
+    int nbytes = 0;
+
+    for(TBranch* branch : branches) {
+      nbytes += branch->GetEntry(treeEntry);
+    }
+
+    return nbytes;
+  }
+
   //---------------------------------------------------------------------------
   void FluxReader::InitialMessage()
   {
@@ -402,6 +943,7 @@ namespace flxrd
       for(const std::string& branch : fBranchNames) {
         // std::cout << "Turning on branch " << branch << std::endl;
         fluxTree->SetBranchStatus(branch.c_str(), 1); // Turn on the branch
+        fBranchPaths[branch] = branch;
 
         // Add the actual TBranch to the list of TBranches,
         // and abort if the branch does not exist to avoid a seg fault
@@ -457,6 +999,7 @@ namespace flxrd
         }
 
         fluxTree->SetBranchStatus(branchPath.c_str(), 1); // Turn on the branch
+        fBranchPaths[branch] = branchPath;
         fluxTree->SetBranchAddress(branchPath.c_str(), m[branch]); // Point the branch into the class Dk2Nu object 
       }
 
@@ -482,6 +1025,8 @@ namespace flxrd
     }
     std::cout << std::endl;
 
+    SplitBranches(); // Decide which branches are read before an entry is selected
+
     // Make sure the NuRay vector in the class Dk2Nu object is large enough
     // to have an entry/index for all the detectors (and each detector usage)
     if(fReweightNuRay) {
@@ -512,13 +1057,25 @@ namespace flxrd
       // If that value is 0, increment by 1
       index += (det.GetUses() == 0 ? 1 : det.GetUses());
     }
+
+    // Each detector array gets one NuRay, which its Spectra fill with one position at a time
+    for(const auto& array : fArrays) {
+      if(fNuRayIndex.find(array.GetName()) != fNuRayIndex.end()) {
+        std::cerr << "Detector array " << array.GetName()
+                  << " has the same name as a detector. Asserting 0." << std::endl;
+        assert(0);
+      }
+
+      fNuRayIndex[array.GetName()] = index;
+      ++index;
+    }
     fNuRayIndex["znull"] = index; // This will signal the last NuRay index
 
     return;
   }
 
   //---------------------------------------------------------------------------
-  TVector3 FluxReader::Smear(const Detector& det, double rr)
+  TVector3 FluxReader::Smear(const Detector& det, int i_use, double rr)
   {
     // ISSUE: Add z offset? Fiducial volume cut?
 
@@ -527,12 +1084,17 @@ namespace flxrd
     double yrange = det.GetHalfSizeY();
     double zrange = det.GetHalfSizeZ();
 
-    // Randomly choose point in detector
-    double x = gRandom->Uniform(-1.*xrange, xrange);
-    double y = gRandom->Uniform(-1.*yrange, yrange);
-    double z = gRandom->Uniform(-1.*zrange, zrange);
+    // Choose the point of this use in the unit cube, and scale it to the detector
+    double u[3];
+    fSmearSampler.Point(i_use, u);
+
+    // In the default mode, this is the same as gRandom->Uniform(-range, range) for each axis
+    double x = -1.*xrange + 2.*xrange*u[0];
+    double y = -1.*yrange + 2.*yrange*u[1];
+    double z = -1.*zrange + 2.*zrange*u[2];
 
     // If the detector is not square, make sure point lies inside radius sqrt(rr)
+    // A rejected point is replaced by a random one, which is not stratified
     while((rr < (x*x + y*y)) && (rr > 0.)) {
       x = gRandom->Uniform(-1.*xrange, xrange);
       y = gRandom->Uniform(-1.*yrange, yrange);
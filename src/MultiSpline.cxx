@@ -0,0 +1,126 @@
+#include "MultiSpline.h"
+
+// C/C++ Includes
+#include <algorithm>
+
+// Root Includes
+#include "TSpline.h"
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  MultiSpline::MultiSpline(const std::vector<TSpline3*>& splines)
+    : fSplines(splines), fShared(false), fNKnots(0)
+  {
+    // Separate the identity factors, which are never evaluated
+    for(int i_spline = 0, n_spline = fSplines.size(); i_spline < n_spline; ++i_spline) {
+      if(fSplines[i_spline]) {
+        fActive.push_back(i_spline);
+      }
+      else {
+        fIdentity.push_back(i_spline);
+      }
+    }
+
+    if(fActive.empty()) {
+      return;
+    }
+
+    // Check that every spline has the same knots as the first one
+    TSpline3* first = fSplines[fActive[0]];
+    fNKnots = first->GetNp();
+    fShared = (fNKnots > 1);
+
+    double x = 0., y = 0., b = 0., c = 0., d = 0.;
+    double x0 = 0., y0 = 0.;
+    for(const auto& i_spline : fActive) {
+      if(!fShared) { break; }
+
+      TSpline3* s = fSplines[i_spline];
+      if(s->GetNp() != fNKnots) {
+        fShared = false;
+        break;
+      }
+
+      for(int i_knot = 0; i_knot < fNKnots; ++i_knot) {
+        first->GetKnot(i_knot, x0, y0);
+        s->GetKnot(i_knot, x, y);
+        if(x != x0) {
+          fShared = false;
+          break;
+        }
+      }
+    }
+
+    if(!fShared) {
+      return;
+    }
+
+    // Tabulate the knots and coefficients
+    const int n_active = fActive.size();
+    fKnots.resize(fNKnots);
+    fCoeffs.resize(4*n_active*fNKnots);
+
+    for(int i_knot = 0; i_knot < fNKnots; ++i_knot) {
+      for(int i_active = 0; i_active < n_active; ++i_active) {
+        fSplines[fActive[i_active]]->GetCoeff(i_knot, x, y, b, c, d);
+
+        double* coeff = &fCoeffs[4*(i_knot*n_active + i_active)];
+        coeff[0] = y;
+        coeff[1] = b;
+        coeff[2] = c;
+        coeff[3] = d;
+      }
+
+      fKnots[i_knot] = x;
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  void MultiSpline::Eval(double x, double* vals) const
+  {
+    for(const auto& i_spline : fIdentity) {
+      vals[i_spline] = 1.;
+    }
+
+    if(fActive.empty()) {
+      return;
+    }
+
+    if(!fShared) {
+      for(const auto& i_spline : fActive) {
+        vals[i_spline] = fSplines[i_spline]->Eval(x);
+      }
+
+      return;
+    }
+
+    // One knot search for all of the splines
+    const int n_active = fActive.size();
+    const int i_knot = FindSegment(x);
+    const double dx = x - fKnots[i_knot];
+    const double* coeff = &fCoeffs[4*i_knot*n_active];
+
+    for(int i_active = 0; i_active < n_active; ++i_active, coeff += 4) {
+      vals[fActive[i_active]] = coeff[0] + dx*(coeff[1] + dx*(coeff[2] + dx*coeff[3]));
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  int MultiSpline::FindSegment(double x) const
+  {
+    // TSpline3 uses the segment whose lower knot is strictly below x,
+    // the first segment below the first knot,
+    // and the second to last segment (not the last knot) above the last knot
+    if(x <= fKnots.front()) {
+      return 0;
+    }
+    if(x >= fKnots.back()) {
+      return fNKnots - 2;
+    }
+
+    return (std::lower_bound(fKnots.begin(), fKnots.end(), x) - fKnots.begin()) - 1;
+  }
+}
@@ -4,7 +4,7 @@
 #include <iostream>
 
 // Package Includes
-#include "XSec.h"
+#include "XSecRegistry.h"
 
 namespace flxrd
 {
@@ -134,20 +134,18 @@ namespace flxrd
       }
     }
 
-    // Create XSec object to get a list of valid cross sections
-    XSec* xs = new XSec();
+    // The registry opens the cross section file once for the whole process to get a list of valid cross sections
+    XSecRegistry& registry = XSecRegistry::Instance();
 
-    // If the cross section was invalid, show the user a list of valid inputs, clean up, and return
-    if(!xs->IsValidProcess(xsec) && xsec.compare("NoXSec")) {
+    // If the cross section was invalid, show the user a list of valid inputs and return
+    if(!registry.IsValidProcess(xsec)) {
       std::cout << "The input cross section is not valid. The following are valid:" << std::endl;
-      xs->ListIntTypes();
-      delete xs;
+      registry.ListIntTypes();
       return;
     }
 
     fXSec.push_back(xsec); // Add cross section to vector
 
-    delete xs; // Clean up
     UpdateIndices(); // Make sure the Parameters' Indices object is aware of this change
     return;
   }
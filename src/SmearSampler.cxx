@@ -0,0 +1,84 @@
+#include "SmearSampler.h"
+
+// C/C++ Includes
+#include <utility>
+
+// Root Includes
+#include "TRandom.h"
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  SmearSampler::SmearSampler(Mode mode)
+    : fMode(mode), fNUses(0)
+  {
+    fShift.fill(0.);
+  }
+
+  //---------------------------------------------------------------------------
+  void SmearSampler::NewRay(int nUses)
+  {
+    fNUses = nUses;
+
+    if(fMode == kHalton) {
+      for(auto& shift : fShift) {
+        shift = gRandom->Rndm();
+      }
+    }
+    else if(fMode == kStratified) {
+      // A random permutation of the slices along each axis, so the axes are not correlated
+      for(auto& slices : fSlices) {
+        slices.resize(fNUses);
+        for(int i_use = 0; i_use < fNUses; ++i_use) {
+          slices[i_use] = i_use;
+        }
+
+        for(int i_use = fNUses - 1; i_use > 0; --i_use) {
+          std::swap(slices[i_use], slices[gRandom->Integer(i_use + 1)]);
+        }
+      }
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void SmearSampler::Point(int i_use, double* u)
+  {
+    static const unsigned int kBases[3] = {2, 3, 5};
+
+    for(int i_axis = 0; i_axis < 3; ++i_axis) {
+      if(fMode == kHalton) {
+        // Skip the first Halton point, which is 0 on every axis
+        u[i_axis] = RadicalInverse(i_use + 1, kBases[i_axis]) + fShift[i_axis];
+        if(u[i_axis] >= 1.) {
+          u[i_axis] -= 1.;
+        }
+      }
+      else if(fMode == kStratified) {
+        u[i_axis] = (fSlices[i_axis][i_use] + gRandom->Rndm())/fNUses;
+      }
+      else {
+        u[i_axis] = gRandom->Rndm();
+      }
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  double SmearSampler::RadicalInverse(unsigned int i, unsigned int base)
+  {
+    const double inv_base = 1./base;
+
+    double ret = 0.;
+    double digit_scale = inv_base;
+    while(i > 0) {
+      ret += (i % base)*digit_scale;
+      i /= base;
+      digit_scale *= inv_base;
+    }
+
+    return ret;
+  }
+}
@@ -1,14 +1,20 @@
 #include "Spectra.h"
 
+// C/C++ Includes
+#include <algorithm>
+#include <iostream>
+
 // Root Includes
-#include "TF1.h"
+#include "TDirectory.h"
+#include "TH1.h"
 #include "TObject.h"
 #include "TSpline.h"
 
 // Package Includes
+#include "Combiner.h"
 #include "ParticleParam.h"
 #include "Utilities.h"
-#include "XSec.h"
+#include "XSecRegistry.h"
 
 // Other External Includes
 #include "dk2nu.h"
@@ -18,7 +24,8 @@ namespace flxrd
   //---------------------------------------------------------------------------
   Spectra::Spectra(Parameters params, std::string title,
                    const Var& varx, const Weight& wei, TObject* extWeights)
-    : fParams(params), fTitle(title), fVarX(varx), fWei(wei)
+    : fParams(params), fTitle(title), fWriteEmpty(false), fCombine(false), fVarX(varx), fWei(wei),
+      fBootstrap(nullptr)
   {
     if(extWeights) {
       fExtWeights = extWeights;
@@ -68,10 +75,137 @@ namespace flxrd
     return nu->tgtexit.tptype;
   }
 
+  //---------------------------------------------------------------------------
+  bool Spectra::SetCurrentEntry(bsim::Dk2Nu* nu)
+  {
+    return SetCurrentEntry(nu->decay.ntype, GetAncestorPDG(nu));
+  }
+
+  //---------------------------------------------------------------------------
+  bool Spectra::SetCurrentEntry(int nuPDG, int ancestorPDG)
+  {
+    if(!fParams.SetCurrentNuFlav(nuPDG)) {
+      return false;
+    }
+
+    // Use the absolute value of the parent PDG if applicable
+    int parPDG = ( (fParams.IsSignSensitive()) ? ancestorPDG : abs(ancestorPDG) );
+
+    return fParams.SetCurrentParent(parPDG);
+  }
+
+  //---------------------------------------------------------------------------
+  void Spectra::CalcXSecWeights(bsim::Dk2Nu* nu, int i_nuray, int i_det)
+  {
+    const int n_xsec = fParams.NXSec();
+
+    // Evaluate all of the cross sections at the neutrino energy at once
+    // If there are only identity factors, fXSecValues is already filled with 1
+    const MultiSpline& xsecs = fXSecTables[i_det*fParams.NFlav() + fParams.GetCurrentNuFlav()];
+    if(!xsecs.IsIdentity()) {
+      xsecs.Eval(nu->nuray[i_nuray].E, &fXSecValues[0]);
+    }
+
+    // Calculate the standard weight, apart from the cross section
+    double weight = nu->decay.nimpwt * nu->nuray[i_nuray].wgt * fDefaultWeightCorrection;
+
+    if(fWei.IsLinear()) {
+      // The Weight is proportional to its input, so evaluate it once and scale it
+      double wei = fWei(weight, nu, i_nuray, fExtWeights);
+
+      for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+        fXSecWeights[i_xsec] = wei * fXSecValues[i_xsec];
+      }
+    }
+    else {
+      for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+        fXSecWeights[i_xsec] = fWei(weight * fXSecValues[i_xsec], nu, i_nuray, fExtWeights);
+      }
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void Spectra::MaterializedMessage(int n_made) const
+  {
+    std::cout << fTitle << ": " << n_made << " of " << fParams.MaxMaster()
+              << " histograms received entries";
+    if(fWriteEmpty) {
+      std::cout << " (the rest are written as empty placeholders)";
+    }
+    std::cout << "." << std::endl;
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  int Spectra::FindBin(const std::vector<double>& edges, double x)
+  {
+    if(x < edges.front()) {
+      return 0; // Underflow
+    }
+    if(!(x < edges.back())) {
+      return edges.size(); // Overflow, which also catches NaN
+    }
+
+    // The bin is the number of edges at or below x
+    return std::upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+  }
+
+  //---------------------------------------------------------------------------
+  void Spectra::WriteStores(TDirectory* out)
+  {
+    TDirectory* temp = gDirectory; // Store the current directory to come back to later
+
+    std::string det_name = ""; // Used to compare the current detector to the previous one
+
+    int n_made = 0; // Number of histograms that were filled (or requested) before writing
+
+    for(const auto& index : fParams) { // Loop over all Parameters indices
+      fParams.SetIndices(index); // Set the current master
+
+      // Check if the detector has changed since the last Parameters master index
+      if(det_name.compare(fParams.GetDetName(fParams.GetCurrentDet()))) {
+        det_name = fParams.GetDetName(fParams.GetCurrentDet());
+        out->cd(); // Go to the top level of the input directory
+
+        // Make the detector directory if needed, and go into it
+        if( !(out->GetListOfKeys()->FindObject(det_name.c_str())) ) {
+          out->mkdir(det_name.c_str());
+        }
+        out->cd(det_name.c_str());
+      }
+
+      // Master indices that never received an entry are skipped, unless placeholders were requested
+      if(HasStore(index) || ExistingHist(index)) {
+        MakeStoredHist(index);
+        ++n_made;
+
+        // The histogram now holds the contents, so the store is no longer needed
+        FreeStore(index, out, det_name);
+      }
+      else if(fWriteEmpty) {
+        MakeStoredHist(index); // Keep the placeholder, so it is included in any combinations
+      }
+
+      if(TObject* h = ExistingHist(index)) {
+        gDirectory->WriteTObject(h);
+      }
+    }
+
+    MaterializedMessage(n_made); // Report how many histograms were actually needed
+
+    temp->cd(); // Go back to the original directory
+    return;
+  }
+
   //---------------------------------------------------------------------------
   void Spectra::SetupXSec()
   {
-    XSec* xsec = new XSec(); // Create XSec object
+    // Splines are shared between all Spectra through the registry,
+    // which opens the cross section file and builds each spline only once
+    XSecRegistry& registry = XSecRegistry::Instance();
 
     std::string xsecname = "";
 
@@ -87,30 +221,103 @@ namespace flxrd
         std::string tar = fParams.GetDetector(fParams.GetCurrentDet()).GetTarget();
         std::string curr = fParams.GetXSecName(fParams.GetCurrentXSec());
 
-        if(curr.compare("NoXSec")) { // The comparison returns 0 if the two strings match...
-          fXSecSplines[xsecname] = xsec->GetXSec(pdg, tar, curr, true); // Create and store the spline
-        }
-        else {
-          // For NoXSec, or no cross section, create a line at 1
-          TF1* f = new TF1("f", "1", 0., 120.);
-          TSpline3* s = new TSpline3("", 0., 120., f, 120);
-          fXSecSplines[xsecname] = s;
+        // For NoXSec, or no cross section, the registry returns nullptr, which is an identity factor
+        fXSecSplines[xsecname] = registry.GetXSec(pdg, tar, curr, true);
+      }
+    }
+
+    // Group the splines by neutrino flavor and detector, in cross section order,
+    // so that Fill can evaluate all of the cross sections for a neutrino ray together
+    fXSecTables.clear();
+    for(int i_det = 0, n_det = fParams.NDet(); i_det < n_det; ++i_det) {
+      for(int i_flav = 0, n_flav = fParams.NFlav(); i_flav < n_flav; ++i_flav) {
+        std::vector<TSpline3*> splines;
+        for(int i_xsec = 0, n_xsec = fParams.NXSec(); i_xsec < n_xsec; ++i_xsec) {
+          splines.push_back(fXSecSplines[XSecName(i_flav, i_xsec, i_det)]);
         }
+
+        fXSecTables.push_back(MultiSpline(splines));
+      }
+    }
+
+    fXSecValues .assign(fParams.NXSec(), 1.);
+    fXSecWeights.assign(fParams.NXSec(), 0.);
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void Spectra::WriteCombinedHists(TDirectory* out, const std::vector<TH1*>& hists)
+  {
+    TDirectory* temp = gDirectory;
+
+    const int n_group = fParams.NFlav()*fParams.NPar(); // Number of histograms with the same cross section and detector
+
+    int n_combined = 0;
+
+    for(int i_det = 0, n_det = fParams.NDet(); i_det < n_det; ++i_det) {
+      out->cd(fParams.GetDetName(i_det).c_str());
+
+      std::vector<TH1*> combined;
+      for(int i_xsec = 0, n_xsec = fParams.NXSec(); i_xsec < n_xsec; ++i_xsec) {
+        const int first = n_group*(i_xsec + fParams.NXSec()*i_det);
+
+        std::vector<TH1*> group(hists.begin() + first, hists.begin() + first + n_group);
+        Combiner::CombineHists(fParams, fTitle, first, group, true, true, true, combined);
       }
+
+      for(TH1* h : combined) {
+        gDirectory->WriteTObject(h);
+        delete h;
+      }
+
+      n_combined += combined.size();
     }
 
-    delete xsec; // Clean up
+    std::cout << fTitle << ": wrote " << n_combined << " combined histograms." << std::endl;
 
+    temp->cd();
     return;
   }
 
+  //---------------------------------------------------------------------------
+  SpectraMeta Spectra::MakeMeta() const
+  {
+    SpectraMeta meta;
+
+    meta.fTitle         = fTitle;
+    meta.fSignSensitive = fParams.fSignSensitive;
+    meta.fAncestorPar   = fParams.fAncestorPar;
+
+    for(const auto& flav : fParams.fNuFlav) {
+      meta.fNuFlavs.push_back(std::make_pair(flav.GetName(), flav.GetPDG()));
+    }
+    for(const auto& par : fParams.fParent) {
+      meta.fParents.push_back(std::make_pair(par.GetName(), par.GetPDG()));
+    }
+
+    meta.fXSecs = fParams.fXSec;
+
+    for(const auto& det : fParams.fDet) {
+      meta.fDets.push_back({det.GetDetName(), det.GetTarget(), det.GetUses()});
+    }
+
+    return meta;
+  }
+
   //---------------------------------------------------------------------------
   std::string Spectra::XSecName()
+  {
+    return XSecName(fParams.GetCurrentNuFlav(), fParams.GetCurrentXSec(), fParams.GetCurrentDet());
+  }
+
+  //---------------------------------------------------------------------------
+  std::string Spectra::XSecName(int i_flav, int i_xsec, int i_det) const
   {
     // Create a label by conglomerating the three strings
-    std::string ret =   fParams.GetNuFlav(  fParams.GetCurrentNuFlav()).GetName()
-                      + fParams.GetXSecName(fParams.GetCurrentXSec())
-                      + fParams.GetDetName( fParams.GetCurrentDet());
+    std::string ret =   fParams.GetNuFlav(  i_flav).GetName()
+                      + fParams.GetXSecName(i_xsec)
+                      + fParams.GetDetName( i_det);
 
     return ret;
   }
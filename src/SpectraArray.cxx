@@ -0,0 +1,220 @@
+#include "SpectraArray.h"
+
+// C/C++ Includes
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+// Root Includes
+#include "TArrayD.h"
+#include "TDirectory.h"
+#include "TH1.h"
+#include "TH2D.h"
+
+// Other External Includes
+#include "dk2nu.h"
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  SpectraArray::SpectraArray(Parameters params, std::string title, const DetectorArray& array,
+                             std::string labelx, std::vector<double> binsx, const Var& varx,
+                             const Weight& wei, TObject* extWeights)
+    : Spectra(ArrayParameters(params, array), title, varx, wei, extWeights),
+      fArray(array), fRays(nullptr), fLabelX(labelx), fBinsX(binsx)
+  {
+    assert(fBinsX.size() >= 2); // The axis needs at least one bin
+
+    // Reserve a slot for each Parameters master index
+    // Many combinations never receive an entry, so the stores themselves are made by Fill
+    fStores.assign(fParams.MaxMaster(), Store());
+    fHists .assign(fParams.MaxMaster(), nullptr);
+  }
+
+  //---------------------------------------------------------------------------
+  SpectraArray::~SpectraArray()
+  {
+    for(TH1* h : fHists) {
+      delete h;
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  Parameters SpectraArray::ArrayParameters(Parameters params, const DetectorArray& array)
+  {
+    while(params.NDet() > 0) {
+      params.RemoveDetector(params.GetDetName(0));
+    }
+    params.AddDetector(array.GetDetector());
+
+    return params;
+  }
+
+  //---------------------------------------------------------------------------
+  TH1* SpectraArray::GetHist(int i_hist)
+  {
+    // Check that there actually is a histogram to return
+    const int n_hist = fHists.size();
+    if(i_hist < 0 || i_hist >= n_hist) {
+      std::cout << "Input histogram index is out of range." << std::endl;
+      assert(false);
+    }
+
+    return MakeHist(i_hist);
+  }
+
+  //---------------------------------------------------------------------------
+  void SpectraArray::Fill(bsim::Dk2Nu* nu, std::map<std::string, int> nurayIndices)
+  {
+    // Set the neutrino flavor and parent, and stop if the Parameters do not include them
+    if(!SetCurrentEntry(nu)) {
+      return;
+    }
+
+    fParams.SetCurrentDet(0); // The array is the only detector
+
+    // The Var and Weight read the neutrino ray, so each position is copied into the array's NuRay slot in turn
+    const int i_nuray = nurayIndices[fArray.GetName()];
+    const double* energies = fRays->GetEnergies();
+    const double* weights  = fRays->GetWeights();
+
+    // Histograms for consecutive cross sections are separated by this many master indices
+    const int n_xsec = fParams.NXSec();
+    const int xsec_step = fParams.NFlav()*fParams.NPar();
+
+    fParams.SetCurrentXSec(0);
+    const int first_hist = fParams.GetCurrentMaster(); // Get the histogram index of the first cross section
+
+    const int n_pos  = fArray.NPositions();
+    const int n_cell = fBinsX.size() + 1; // Bins of one position, including underflow and overflow
+
+    for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+      Store& store = fStores[first_hist + i_xsec*xsec_step];
+      if(store.fSumw.empty()) { // Allocate the store on its first entry
+        store.fSumw .assign(n_pos*n_cell, 0.);
+        store.fSumw2.assign(n_pos*n_cell, 0.);
+        store.fEntries = 0.;
+      }
+    }
+
+    for(int i_pos = 0; i_pos < n_pos; ++i_pos) {
+      nu->nuray[i_nuray].E   = energies[i_pos];
+      nu->nuray[i_nuray].wgt = weights [i_pos];
+
+      CalcXSecWeights(nu, i_nuray, 0);
+
+      const int cell = i_pos*n_cell + FindBin(fBinsX, fVarX(nu, i_nuray));
+
+      for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+        Store& store = fStores[first_hist + i_xsec*xsec_step];
+        const double w = fXSecWeights[i_xsec];
+
+        store.fEntries += 1.;
+        store.fSumw [cell] += w;
+        store.fSumw2[cell] += w*w;
+      } // Loop over cross sections
+    } // Loop over positions
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void SpectraArray::WriteHists(TDirectory* out)
+  {
+    // The array is the only detector, so every histogram goes in its directory
+    WriteStores(out);
+
+    // Every position is combined at once
+    if(fCombine) {
+      WriteCombinedHists(out, fHists);
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  bool SpectraArray::HasStore(int i_hist) const
+  {
+    return !fStores[i_hist].fSumw.empty();
+  }
+
+  //---------------------------------------------------------------------------
+  TObject* SpectraArray::ExistingHist(int i_hist) const
+  {
+    return fHists[i_hist];
+  }
+
+  //---------------------------------------------------------------------------
+  void SpectraArray::MakeStoredHist(int i_hist)
+  {
+    MakeHist(i_hist);
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void SpectraArray::FreeStore(int i_hist, TDirectory* out, const std::string& det_name)
+  {
+    std::vector<double>().swap(fStores[i_hist].fSumw);
+    std::vector<double>().swap(fStores[i_hist].fSumw2);
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  SpectraMeta SpectraArray::MakeMeta() const
+  {
+    SpectraMeta meta = Spectra::MakeMeta();
+
+    std::vector<double> posEdges;
+    for(int i_pos = 0, n_pos = fArray.NPositions(); i_pos <= n_pos; ++i_pos) {
+      posEdges.push_back(i_pos);
+    }
+
+    meta.fType   = "SpectraArray";
+    meta.fDim    = 2;
+    meta.fLabels = {fLabelX, "Position"};
+    meta.fBins   = {fBinsX, posEdges};
+
+    for(int i_pos = 0, n_pos = fArray.NPositions(); i_pos < n_pos; ++i_pos) {
+      TVector3 pos = fArray.GetPosition(i_pos);
+      meta.fPositions.push_back({pos.X(), pos.Y(), pos.Z()});
+    }
+
+    return meta;
+  }
+
+  //---------------------------------------------------------------------------
+  TH1* SpectraArray::MakeHist(int i_hist)
+  {
+    const int nx = fBinsX.size() - 1;
+    const int n_pos = fArray.NPositions();
+
+    if(!fHists[i_hist]) {
+      // NameTag moves the Parameters indices to i_hist
+      std::string hist_title = fTitle + "_" + fParams.NameTag(i_hist);
+      std::string axis_label = ";" + fLabelX + ";Position";
+
+      // Position i_pos is the bin from i_pos to i_pos + 1
+      fHists[i_hist] = new TH2D(hist_title.c_str(), axis_label.c_str(),
+                                nx, &fBinsX[0], n_pos, 0., n_pos);
+      fHists[i_hist]->SetDirectory(nullptr); // Owned by this Spectra, not by the current directory
+      fHists[i_hist]->Sumw2();
+    }
+
+    const Store& store = fStores[i_hist];
+    if(!store.fSumw.empty()) {
+      // The store is [position][bin], which is the layout of ROOT's cells after the y underflow row
+      TH1* h = fHists[i_hist];
+      double* contents = dynamic_cast<TArrayD*>(h)->GetArray();
+      double* errors   = h->GetSumw2()->GetArray();
+
+      std::copy(store.fSumw .begin(), store.fSumw .end(), contents + (nx + 2));
+      std::copy(store.fSumw2.begin(), store.fSumw2.end(), errors   + (nx + 2));
+
+      h->ResetStats(); // Recalculate the statistics from the new contents
+      h->SetEntries(store.fEntries);
+    }
+
+    return fHists[i_hist];
+  }
+}
@@ -1,10 +1,13 @@
 #include "SpectraCorrDet.h"
 
 // C/C++ Includes
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <vector>
 
 // Root Includes
+#include "TArrayD.h"
 #include "TDirectory.h"
 #include "TH1.h"
 #include "TH1D.h"
@@ -12,123 +15,298 @@
 #include "TObject.h"
 #include "TSpline.h"
 
+// Package Includes
+#include "Bootstrap.h"
+
 namespace flxrd
 {
+  namespace
+  {
+    /// Add the contents, squared weights, and statistics of h to sum, which must have the same binning
+    /// This works directly on the bin arrays, skipping the per bin lookups and checks of TH1::Add
+    template <class T>
+    void AddContents(T* sum, const T* h)
+    {
+      double*       s = sum->GetArray();
+      const double* a = h->GetArray();
+      for(int i = 0, n = sum->GetSize(); i < n; ++i) {
+        s[i] += a[i];
+      }
+
+      if(sum->GetSumw2N() > 0 && h->GetSumw2N() > 0) {
+        double*       s2 = sum->GetSumw2()->GetArray();
+        const double* a2 = h->GetSumw2()->GetArray();
+        for(int i = 0, n = sum->GetSize(); i < n; ++i) {
+          s2[i] += a2[i];
+        }
+      }
+
+      // The statistics are sums as well
+      double sumStats[TH1::kNstat] = {0.};
+      double hStats  [TH1::kNstat] = {0.};
+      sum->GetStats(sumStats);
+      h  ->GetStats(hStats);
+      for(int i = 0; i < TH1::kNstat; ++i) {
+        sumStats[i] += hStats[i];
+      }
+
+      const double entries = sum->GetEntries() + h->GetEntries();
+      sum->PutStats(sumStats);
+      sum->SetEntries(entries);
+    }
+  }
+
   //---------------------------------------------------------------------------
   SpectraCorrDet::SpectraCorrDet(Parameters params, std::string title,
                                  std::string detX, std::string detY,
                                  std::string labelx, std::vector<double> binsx, const Var& varx,
                                  const Weight& wei, TObject* extWeights)
+    : SpectraCorrDet(params, title, std::vector<std::string>{detX, detY},
+                     labelx, binsx, varx, wei, extWeights)
+  {
+  }
+
+  //---------------------------------------------------------------------------
+  SpectraCorrDet::SpectraCorrDet(Parameters params, std::string title,
+                                 std::vector<std::string> dets,
+                                 std::string labelx, std::vector<double> binsx, const Var& varx,
+                                 const Weight& wei, TObject* extWeights)
     : Spectra(params, title, varx, wei, extWeights), fIsNormalized(false), fAlreadyCombined(false)
   {
     assert(params.NDet() >= 2); // There need to be at least two detectors in the Parameters object
-
-    // Initialize the two indices
-    i_detX = -1;
-    i_detY = -1;
+    assert(dets.size() >= 2); // There need to be at least two detectors to correlate
 
     // Loop through the input parameters object,
-    // look for detectors that match the names of detX and detY inputs
-    for(unsigned int i_det = 0, n_det = params.NDet(); i_det < n_det; ++i_det) {
-      if(!detX.compare(params.GetDetName(i_det))) {
-        i_detX = i_det; // Store the index that matched detX
+    // look for detectors that match the names of the input detectors
+    for(const std::string& det : dets) {
+      int index = -1;
+      for(unsigned int i_det = 0, n_det = params.NDet(); i_det < n_det; ++i_det) {
+        if(!det.compare(params.GetDetName(i_det))) {
+          index = i_det; // Store the index that matched det
+        }
       }
-      if(!detY.compare(params.GetDetName(i_det))) {
-        i_detY = i_det; // Store the index that matched detY
+
+      if(index == -1) {
+        std::cout << "The detector " << det << " is not in the Parameters." << std::endl;
+        assert(false);
       }
+
+      if(std::find(fCorrDets.begin(), fCorrDets.end(), index) != fCorrDets.end()) {
+        std::cout << "The detector " << det << " is included more than once." << std::endl;
+        assert(false);
+      }
+
+      fCorrDets.push_back(index);
     }
 
-    assert(i_detX != -1 && i_detY != -1); // Make sure both detectors were found
+    fLabelX = labelx;
+    fBinsX  = binsx;
 
-    fParams.SetCurrentDet(i_detY); // Set the current detector to detY
+    // Every pair, with the detector that comes first as the x axis detector
+    for(unsigned int i_x = 0, n_x = fCorrDets.size(); i_x < n_x; ++i_x) {
+      for(unsigned int i_y = i_x + 1; i_y < n_x; ++i_y) {
+        DetPair pair;
+        pair.i_detX = fCorrDets[i_x];
+        pair.i_detY = fCorrDets[i_y];
+
+        CreateHists(pair, labelx, binsx);
+        fPairs.push_back(pair);
+      }
+    }
+
+    const int n_det = fParams.NDet();
+    fUseBins       .resize(n_det);
+    fUseWeights    .resize(n_det*n_det);
+    fUseWeightsDone.assign(n_det*n_det, false);
+  }
 
-    CreateHists(detX, detY, labelx, binsx);
+  //---------------------------------------------------------------------------
+  SpectraCorrDet::~SpectraCorrDet()
+  {
+    for(DetPair& pair : fPairs) {
+      for(TH2D* h : pair.fHists) { delete h; }
+      for(TH1D* h : pair.fNorms) { delete h; }
+      for(TH2D* h : pair.fCross) { delete h; }
+    }
   }
 
   //---------------------------------------------------------------------------
   TH1* SpectraCorrDet::GetHist(int i_hist)
   {
-    // Normalize the histograms by fNorms if they have not already been
+    // Normalize the histograms by the norms if they have not already been
     if(!fIsNormalized) {
       Normalize();
     }
 
-    const int n_hist = fHists.size();
-    if(i_hist < 0 || i_hist >= n_hist) {
-      std::cout << "Input histogram index is out of range." << std::endl;
-      assert(false);
+    // Find the pair the index falls in
+    if(i_hist >= 0) {
+      for(const DetPair& pair : fPairs) {
+        const int n_hist = pair.fHists.size();
+        if(i_hist < n_hist) {
+          return pair.fHists[i_hist];
+        }
+        i_hist -= n_hist;
+      }
     }
 
-    return fHists[i_hist];
+    std::cout << "Input histogram index is out of range." << std::endl;
+    assert(false);
+    return nullptr;
   }
 
   //---------------------------------------------------------------------------
   void SpectraCorrDet::Fill(bsim::Dk2Nu* nu, std::map<std::string, int> nurayIndices)
   {
-    int nuPDG = nu->decay.ntype;
-
-    if(!fParams.SetCurrentNuFlav(nuPDG)) {
+    // Set the neutrino flavor and parent, and stop if the Parameters do not include them
+    if(!SetCurrentEntry(nu)) {
       return;
     }
 
-    int parPDG = ( (fParams.IsSignSensitive()) ?     GetAncestorPDG(nu)
-                                               : abs(GetAncestorPDG(nu)) );
+    // Histograms for consecutive cross sections are separated by this many indices
+    const int n_xsec = fParams.NXSec();
+    const int xsec_step = fParams.NFlav()*fParams.NPar();
 
-    if(!fParams.SetCurrentParent(parPDG)) {
-      return;
-    }
+    // Evaluate the variable and find its bin once for each use of each detector
+    // Both axes variables evaluate fVarX, but the x axis is evaluated at detX, and the y axis at detY
+    for(const int i_det : fCorrDets) {
+      int first_nuray = 0, n_use = 0;
+      NuRayRange(nurayIndices, i_det, first_nuray, n_use);
 
-    // Get the first and last indices in the NuRay vector corresponding to the x axis detector
-    int first_nuray_x = nurayIndices[fParams.GetDetName(i_detX)];
-    int last_nuray_x  = first_nuray_x + fParams.GetDetector(i_detX).GetUses();
-    if(last_nuray_x == first_nuray_x) {
-      ++last_nuray_x;
+      fUseBins[i_det].resize(n_use);
+      for(int i_use = 0; i_use < n_use; ++i_use) {
+        fUseBins[i_det][i_use] = FindBin(fBinsX, fVarX(nu, first_nuray + i_use));
+      }
     }
 
-    // Get the first and last indices in the NuRay vector corresponding to the y axis detector
-    int first_nuray_y = nurayIndices[fParams.GetDetName(i_detY)];
-    int last_nuray_y  = first_nuray_y + fParams.GetDetector(i_detY).GetUses();
-      if(last_nuray_y == first_nuray_y) {
-        ++last_nuray_y;
-      }
+    // Both axes have the same binning, so a cell is binX + X*binY, including underflow and overflow
+    const int X = fBinsX.size() + 1;
 
-    fParams.SetCurrentDet(i_detY); // Set the current detector to detY
+    // The weights depend on the cross sections, so they are calculated for each pair as needed
+    std::fill(fUseWeightsDone.begin(), fUseWeightsDone.end(), false);
 
-    for(int i_xsec = 0, n_xsec = fParams.NXSec(); i_xsec < n_xsec; ++i_xsec) {
-      fParams.SetCurrentXSec(i_xsec);
+    for(DetPair& pair : fPairs) {
+      // The cross sections are the ones for detY, for both axes
+      const std::vector<double>& weightsX = UseWeights(nu, nurayIndices, pair.i_detX, pair.i_detY);
+      const std::vector<double>& weightsY = UseWeights(nu, nurayIndices, pair.i_detY, pair.i_detY);
 
-      int i_hist = fParams.GetCurrentMaster() - fParams.MaxMaster(i_detY - 1); // Get the correct histogram index
+      const std::vector<int>& binsX = fUseBins[pair.i_detX];
+      const std::vector<int>& binsY = fUseBins[pair.i_detY];
 
-      for(int i_nuray_x = first_nuray_x; i_nuray_x < last_nuray_x; ++i_nuray_x) {
-        // Calculate the standard weight at the x axis detector
-        double weight_x =   nu->decay.nimpwt * nu->nuray[i_nuray_x].wgt
-                          * fXSecSplines[XSecName()]->Eval(nu->nuray[i_nuray_x].E)
-                          * fDefaultWeightCorrection;
+      const int n_use_x = binsX.size();
+      const int n_use_y = binsY.size();
 
-        for(int i_nuray_y = first_nuray_y; i_nuray_y < last_nuray_y; ++i_nuray_y) {
-          // Calculate the standard weight at the y axis detector
-          double weight_y =   nu->decay.nimpwt * nu->nuray[i_nuray_y].wgt
-                            * fXSecSplines[XSecName()]->Eval(nu->nuray[i_nuray_y].E)
-                            * fDefaultWeightCorrection;
+      // Every replica reweights the entry by its own bootstrap weight
+      const int     n_rep = (fBootstrap ? fBootstrap->NReplicas() : 0);
+      const double* rw    = (fBootstrap ? fBootstrap->Weights()   : nullptr);
 
-          // Evaluate the variables and weights, fill the histograms
-          // Both axes variables evaluate fVarX, but the x axis is evaluated at detX, and the y axis at detY
-          // The weight applied is the weight at detY
-          fHists[i_hist]->Fill(fVarX(nu, i_nuray_x), fVarX(nu, i_nuray_y), fWei(weight_y, nu, i_nuray_y, fExtWeights));
+      fParams.SetCurrentDet(pair.i_detY); // Set the current detector to detY
+      fParams.SetCurrentXSec(0);
+      const int first_hist = fParams.GetCurrentMaster() - fParams.MaxMaster(pair.i_detY - 1); // Get the histogram index of the first cross section
 
-          // This evaluates the weight at detX
-          fNorms[i_hist]->Fill(fVarX(nu, i_nuray_x),                       fWei(weight_x, nu, i_nuray_x, fExtWeights));
-        } // Loop over y detector uses
-      } // Loop over x detector uses
-    } // Loop over cross sections
+      for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+        int i_hist = first_hist + i_xsec*xsec_step;
+
+        double* repHist = nullptr;
+        double* repNorm = nullptr;
+        if(n_rep > 0) {
+          if(pair.fRepHists[i_hist].empty()) { // Allocate the replicas on their first entry
+            pair.fRepHists[i_hist].assign(pair.fHists[i_hist]->GetSize()*n_rep, 0.);
+            pair.fRepNorms[i_hist].assign(pair.fNorms[i_hist]->GetSize()*n_rep, 0.);
+          }
+          repHist = &pair.fRepHists[i_hist][0];
+          repNorm = &pair.fRepNorms[i_hist][0];
+        }
+
+        double* cont   = pair.fHists[i_hist]->GetArray();
+        double* sumw2  = pair.fHists[i_hist]->GetSumw2()->GetArray();
+        double* cross  = pair.fCross[i_hist]->GetArray();
+        double* norm   = pair.fNorms[i_hist]->GetArray();
+        double* normw2 = pair.fNorms[i_hist]->GetSumw2()->GetArray();
+
+        for(int i_use_x = 0; i_use_x < n_use_x; ++i_use_x) {
+          const int    binX = binsX[i_use_x];
+          const double wX   = weightsX[i_use_x*n_xsec + i_xsec];
+
+          // Each pair of an x use and a y use is one fill of both the 2D histogram and the norm
+          // The norm gets the weight at detX from every pair of this x use, so all of them are added at once
+          norm  [binX] += n_use_y*wX;
+          normw2[binX] += n_use_y*wX*wX;
+          for(int i_rep = 0; i_rep < n_rep; ++i_rep) {
+            repNorm[binX*n_rep + i_rep] += n_use_y*wX*rw[i_rep];
+          }
+
+          // The weight applied to the 2D histogram is the weight at detY
+          // The product of the two is kept for the errors of the normalized histogram
+          for(int i_use_y = 0; i_use_y < n_use_y; ++i_use_y) {
+            const int    cell = binX + X*binsY[i_use_y];
+            const double wY   = weightsY[i_use_y*n_xsec + i_xsec];
+
+            cont [cell] += wY;
+            sumw2[cell] += wY*wY;
+            cross[cell] += wY*wX;
+
+            for(int i_rep = 0; i_rep < n_rep; ++i_rep) {
+              repHist[cell*n_rep + i_rep] += wY*rw[i_rep];
+            }
+          } // Loop over y detector uses
+        } // Loop over x detector uses
+
+        // The statistics other than the entries are made from the contents when normalizing
+        pair.fHists[i_hist]->SetEntries(pair.fHists[i_hist]->GetEntries() + n_use_x*n_use_y);
+        pair.fNorms[i_hist]->SetEntries(pair.fNorms[i_hist]->GetEntries() + n_use_x*n_use_y);
+      } // Loop over cross sections
+    } // Loop over detector pairs
 
     return;
   }
 
+  //---------------------------------------------------------------------------
+  void SpectraCorrDet::NuRayRange(const std::map<std::string, int>& nurayIndices, int i_det,
+                                  int& first_nuray, int& n_use) const
+  {
+    first_nuray = nurayIndices.at(fParams.GetDetName(i_det));
+    n_use       = fParams.GetDetector(i_det).GetUses();
+
+    // If GetUses returns 0, the neutrino ray is not smeared, but is still used once
+    if(n_use == 0) {
+      n_use = 1;
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  const std::vector<double>& SpectraCorrDet::UseWeights(bsim::Dk2Nu* nu,
+                                                        const std::map<std::string, int>& nurayIndices,
+                                                        int i_det, int i_xsec_det)
+  {
+    const int index = i_xsec_det*fParams.NDet() + i_det;
+    std::vector<double>& weights = fUseWeights[index];
+
+    if(fUseWeightsDone[index]) {
+      return weights;
+    }
+
+    int first_nuray = 0, n_use = 0;
+    NuRayRange(nurayIndices, i_det, first_nuray, n_use);
+
+    const int n_xsec = fParams.NXSec();
+    weights.resize(n_use*n_xsec);
+
+    for(int i_use = 0; i_use < n_use; ++i_use) {
+      CalcXSecWeights(nu, first_nuray + i_use, i_xsec_det);
+      std::copy(fXSecWeights.begin(), fXSecWeights.end(), weights.begin() + i_use*n_xsec);
+    }
+
+    fUseWeightsDone[index] = true;
+
+    return weights;
+  }
+
   //---------------------------------------------------------------------------
   void SpectraCorrDet::WriteHists(TDirectory* out)
   {
-    // Normalize the histograms by fNorms if they have not already been
+    // Normalize the histograms by the norms if they have not already been
     if(!fIsNormalized) {
       Normalize();
     }
@@ -138,8 +316,18 @@ namespace flxrd
     out->cd();
 
     // These histograms do not need detector directories, so just write them
-    for(unsigned int i_hist = 0, n_hist = fHists.size(); i_hist < n_hist; ++i_hist) {
-      gDirectory->WriteTObject(fHists[i_hist]);
+    for(DetPair& pair : fPairs) {
+      for(unsigned int i_hist = 0, n_hist = pair.fHists.size(); i_hist < n_hist; ++i_hist) {
+        gDirectory->WriteTObject(pair.fHists[i_hist]);
+
+        if(!pair.fRepHists[i_hist].empty()) {
+          WriteSpread(pair, i_hist, out);
+
+          // The spread is written, so the replicas are no longer needed
+          std::vector<double>().swap(pair.fRepHists[i_hist]);
+          std::vector<double>().swap(pair.fRepNorms[i_hist]);
+        }
+      }
     }
 
     temp->cd();
@@ -147,8 +335,10 @@ namespace flxrd
   }
 
   //---------------------------------------------------------------------------
-  void SpectraCorrDet::CombineNuFlavs(std::vector<TH2D*>& newHists,
-                                      std::vector<TH1D*>& newNorms)
+  void SpectraCorrDet::CombineNuFlavs(const DetPair& pair,
+                                      std::vector<TH2D*>& newHists,
+                                      std::vector<TH1D*>& newNorms,
+                                      std::vector<TH2D*>& newCross)
   {
     std::string rep_str = "allnu"; // This string will replace the neutrino flavor name
 
@@ -161,24 +351,26 @@ namespace flxrd
       for(unsigned int i_par  = 0; i_par  < n_par;  ++i_par) {
         // This corresponds to the way Parameters does indexing.
         // NuFlav index 0 is used by not including "+ i_flav" at the end.
-        int index =   n_flav*n_par*n_xsec*i_detY
+        int index =   n_flav*n_par*n_xsec*pair.i_detY
                     + n_flav*n_par*i_xsec
                     + n_flav*i_par;
 
         // CreateHists does not loop over detectors,
-        // So offset the fHists index to compensate
-        int i_hist = index - fParams.MaxMaster(i_detY - 1);
+        // So offset the histogram index to compensate
+        int i_hist = index - fParams.MaxMaster(pair.i_detY - 1);
 
         // Find/create  a stored histogram and copy it into a new histogram for combining
-        TH2D* hHist = (TH2D*)fHists[i_hist]->Clone();
-        TH1D* hNorm = (TH1D*)fNorms[i_hist]->Clone();
+        TH2D* hHist = new TH2D(*pair.fHists[i_hist]);
+        TH1D* hNorm = new TH1D(*pair.fNorms[i_hist]);
+        TH2D* hCross = new TH2D(*pair.fCross[i_hist]);
 
         for(unsigned int i_flav = 1; i_flav < n_flav; ++i_flav) {
           ++i_hist; // This corresponds to an increment of the NuFlav index
 
           // Add in the next histograms
-          hHist->Add(fHists[i_hist]);
-          hNorm->Add(fNorms[i_hist]);
+          AddContents(hHist, pair.fHists[i_hist]);
+          AddContents(hNorm, pair.fNorms[i_hist]);
+          AddContents(hCross, pair.fCross[i_hist]);
         }
 
         // Replace neutrino flavor name by the replacement string
@@ -192,6 +384,7 @@ namespace flxrd
         // Store the final added copies
         newHists.push_back(hHist);
         newNorms.push_back(hNorm);
+        newCross.push_back(hCross);
       } // Loop over parents
     } // Loop over cross sections
 
@@ -199,8 +392,10 @@ namespace flxrd
   }
 
   //---------------------------------------------------------------------------
-  void SpectraCorrDet::CombineParents(std::vector<TH2D*>& newHists,
-                                      std::vector<TH1D*>& newNorms)
+  void SpectraCorrDet::CombineParents(const DetPair& pair,
+                                      std::vector<TH2D*>& newHists,
+                                      std::vector<TH1D*>& newNorms,
+                                      std::vector<TH2D*>& newCross)
   {
     // This function is similar to CombineNuFlav; see its comments for more details.
 
@@ -214,20 +409,22 @@ namespace flxrd
       for(unsigned int i_flav = 0; i_flav < n_flav; ++i_flav) {
         // This corresponds to the way Parameters does indexing.
         // Parent index 0 is used by not including the line "n_flav*i_par".
-        int index =   n_flav*n_par*n_xsec*i_detY
+        int index =   n_flav*n_par*n_xsec*pair.i_detY
                     + n_flav*n_par*i_xsec
                     + i_flav;
 
-        int i_hist = index - fParams.MaxMaster(i_detY - 1);
+        int i_hist = index - fParams.MaxMaster(pair.i_detY - 1);
 
-        TH2D* hHist = (TH2D*)fHists[i_hist]->Clone();
-        TH1D* hNorm = (TH1D*)fNorms[i_hist]->Clone();
+        TH2D* hHist = new TH2D(*pair.fHists[i_hist]);
+        TH1D* hNorm = new TH1D(*pair.fNorms[i_hist]);
+        TH2D* hCross = new TH2D(*pair.fCross[i_hist]);
 
         for(unsigned int i_par  = 1; i_par  < n_par;  ++i_par) {
           i_hist += n_flav; // This corresponds to an increment of the Parent index
 
-          hHist->Add(fHists[i_hist]);
-          hNorm->Add(fNorms[i_hist]);
+          AddContents(hHist, pair.fHists[i_hist]);
+          AddContents(hNorm, pair.fNorms[i_hist]);
+          AddContents(hCross, pair.fCross[i_hist]);
         }
 
         std::string hName = hHist->GetName();
@@ -239,6 +436,7 @@ namespace flxrd
 
         newHists.push_back(hHist);
         newNorms.push_back(hNorm);
+        newCross.push_back(hCross);
       } // Loop over flavors
     } // Loop over cross sections
 
@@ -246,7 +444,7 @@ namespace flxrd
   }
 
   //---------------------------------------------------------------------------
-  void SpectraCorrDet::CombineAll()
+  void SpectraCorrDet::CombineAll(DetPair& pair)
   {
     // This function is similar to CombineNuFlav; see its comments for more details.
 
@@ -254,20 +452,24 @@ namespace flxrd
 
     std::vector<TH2D*> vecCombinedNuFlavHists;
     std::vector<TH1D*> vecCombinedNuFlavNorms;
+    std::vector<TH2D*> vecCombinedNuFlavCross;
     std::vector<TH2D*> vecCombinedParentHists;
     std::vector<TH1D*> vecCombinedParentNorms;
+    std::vector<TH2D*> vecCombinedParentCross;
 
-    CombineNuFlavs(vecCombinedNuFlavHists, vecCombinedNuFlavNorms); // Combine neutrino flavors
-    CombineParents(vecCombinedParentHists, vecCombinedParentNorms); // Combine neutrino parents
+    CombineNuFlavs(pair, vecCombinedNuFlavHists, vecCombinedNuFlavNorms, vecCombinedNuFlavCross); // Combine neutrino flavors
+    CombineParents(pair, vecCombinedParentHists, vecCombinedParentNorms, vecCombinedParentCross); // Combine neutrino parents
 
     // Store the combined flavor and parent histograms in main histogram vectors
     for(unsigned int i = 0, n = vecCombinedNuFlavHists.size(); i < n; ++i) {
-      fHists.push_back(vecCombinedNuFlavHists[i]);
-      fNorms.push_back(vecCombinedNuFlavNorms[i]);
+      pair.fHists.push_back(vecCombinedNuFlavHists[i]);
+      pair.fNorms.push_back(vecCombinedNuFlavNorms[i]);
+      pair.fCross.push_back(vecCombinedNuFlavCross[i]);
     }
     for(unsigned int i = 0, n = vecCombinedParentHists.size(); i < n; ++i) {
-      fHists.push_back(vecCombinedParentHists[i]);
-      fNorms.push_back(vecCombinedParentNorms[i]);
+      pair.fHists.push_back(vecCombinedParentHists[i]);
+      pair.fNorms.push_back(vecCombinedParentNorms[i]);
+      pair.fCross.push_back(vecCombinedParentCross[i]);
     }
 
     const unsigned int n_flav = fParams.NFlav();
@@ -280,14 +482,16 @@ namespace flxrd
       int index = i_xsec*n_flav; // The first index of cross section i_xsec
 
       // Get the combined parent histograms
-      TH2D* hHist = (TH2D*)vecCombinedParentHists[index]->Clone();
-      TH1D* hNorm = (TH1D*)vecCombinedParentNorms[index]->Clone();
+      TH2D* hHist = new TH2D(*vecCombinedParentHists[index]);
+      TH1D* hNorm = new TH1D(*vecCombinedParentNorms[index]);
+      TH2D* hCross = new TH2D(*vecCombinedParentCross[index]);
 
       for(unsigned int i_flav = 1; i_flav < n_flav; ++i_flav) {
         ++index; // Increment the flavor index
 
-        hHist->Add(vecCombinedParentHists[index]);
-        hNorm->Add(vecCombinedParentNorms[index]);
+        AddContents(hHist, vecCombinedParentHists[index]);
+        AddContents(hNorm, vecCombinedParentNorms[index]);
+        AddContents(hCross, vecCombinedParentCross[index]);
       }
 
       // The parent name is already replaced by pulling the combined parent histograms
@@ -298,34 +502,125 @@ namespace flxrd
       hName.replace(firstPos+1, secndPos-firstPos-1, rep_str);
       hHist->SetName(hName.c_str());
 
-      fHists.push_back(hHist);
-      fNorms.push_back(hNorm);
+      pair.fHists.push_back(hHist);
+      pair.fNorms.push_back(hNorm);
+      pair.fCross.push_back(hCross);
     } // Loop over cross sections
 
     return;
   }
 
   //---------------------------------------------------------------------------
-  void SpectraCorrDet::CreateHists(std::string detX, std::string detY, 
-                                   std::string labelx, std::vector<double> binsx)
+  void SpectraCorrDet::CombineReplicas(DetPair& pair)
+  {
+    const int n_flav = fParams.NFlav();
+    const int n_par  = fParams.NPar();
+    const int n_xsec = fParams.NXSec();
+
+    std::vector<std::vector<double> > newHists;
+    std::vector<std::vector<double> > newNorms;
+
+    // Sum n replica sets, starting at first and separated by step, where an empty set was never filled
+    auto combine = [&](int first, int step, int n) {
+      std::vector<double> hist;
+      std::vector<double> norm;
+      for(int i = 0; i < n; ++i) {
+        const std::vector<double>& h  = pair.fRepHists[first + i*step];
+        const std::vector<double>& nm = pair.fRepNorms[first + i*step];
+        if(h.empty()) { continue; }
+
+        if(hist.empty()) {
+          hist.assign(h .size(), 0.);
+          norm.assign(nm.size(), 0.);
+        }
+        for(unsigned int j = 0, n_j = h .size(); j < n_j; ++j) { hist[j] += h [j]; }
+        for(unsigned int j = 0, n_j = nm.size(); j < n_j; ++j) { norm[j] += nm[j]; }
+      }
+
+      newHists.push_back(hist);
+      newNorms.push_back(norm);
+    };
+
+    // The indices are those of CombineNuFlavs, CombineParents, and CombineAll, without the detY offset
+    for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+      for(int i_par = 0; i_par < n_par; ++i_par) {
+        combine(n_flav*n_par*i_xsec + n_flav*i_par, 1, n_flav); // All flavors
+      }
+    }
+    for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+      for(int i_flav = 0; i_flav < n_flav; ++i_flav) {
+        combine(n_flav*n_par*i_xsec + i_flav, n_flav, n_par); // All parents
+      }
+    }
+    for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+      combine(n_flav*n_par*i_xsec, 1, n_flav*n_par); // All flavors and parents
+    }
+
+    pair.fRepHists.insert(pair.fRepHists.end(), newHists.begin(), newHists.end());
+    pair.fRepNorms.insert(pair.fRepNorms.end(), newNorms.begin(), newNorms.end());
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  SpectraMeta SpectraCorrDet::MakeMeta() const
   {
+    SpectraMeta meta = Spectra::MakeMeta();
+
+    // Both axes show the same variable, at detX and detY respectively
+    meta.fType     = "SpectraCorrDet";
+    meta.fDim      = 2;
+    meta.fLabels   = { fLabelX, fLabelX };
+    meta.fBins     = { fBinsX, fBinsX };
+    for(const DetPair& pair : fPairs) {
+      meta.fCorrDets.push_back(std::make_pair(fParams.GetDetName(pair.i_detX),
+                                              fParams.GetDetName(pair.i_detY)));
+    }
+
+    if(fBootstrap) {
+      meta.fNReplicas     = fBootstrap->NReplicas();
+      meta.fBootstrapSeed = fBootstrap->Seed();
+    }
+
+    return meta;
+  }
+
+  //---------------------------------------------------------------------------
+  void SpectraCorrDet::CreateHists(DetPair& pair, std::string labelx, std::vector<double> binsx)
+  {
+    std::string detX = fParams.GetDetName(pair.i_detX);
+    std::string detY = fParams.GetDetName(pair.i_detY);
+
     std::string hist_title = ""; // This will become the title for writing to file
     std::string both_det_str = detX + "_" + detY;
     std::string axis_label = ";" + detX + " " + labelx + ";" + detY + " " + labelx; // This is the x and y axes labels
     const int nBinsX = binsx.size() - 1;
 
-    for(int i = fParams.MaxMaster(i_detY - 1), n = fParams.MaxMaster(i_detY); i < n; ++i) {
+    for(int i = fParams.MaxMaster(pair.i_detY - 1), n = fParams.MaxMaster(pair.i_detY); i < n; ++i) {
       hist_title = fTitle + "_" + fParams.NameTag(i); // Create the full title for writing to file
       hist_title.replace(hist_title.length() - detY.length(), detY.length(), both_det_str);
 
       // Create the 2D histogram of detX vs detY
       TH2D* h2 = new TH2D(hist_title.c_str(), axis_label.c_str(),
                           nBinsX, &binsx[0], nBinsX, &binsx[0]);
-      fHists.push_back(h2);
+      h2->SetDirectory(nullptr); // Owned by this Spectra, not by the current directory
+      h2->Sumw2(); // Store the squared weights, so the errors can be propagated through normalization
+      pair.fHists.push_back(h2);
 
       // Create the 1D histogram of detX events
       TH1D* h1 = new TH1D("", "", nBinsX, &binsx[0]);
-      fNorms.push_back(h1);
+      h1->SetDirectory(nullptr);
+      h1->Sumw2();
+      pair.fNorms.push_back(h1);
+
+      // Create the 2D histogram of the products of the detX and detY weights, which has no errors of its own
+      TH2D* hc = new TH2D("", "", nBinsX, &binsx[0], nBinsX, &binsx[0]);
+      hc->SetDirectory(nullptr);
+      pair.fCross.push_back(hc);
+
+      // The bootstrap replicas are only allocated once filled
+      pair.fRepHists.push_back(std::vector<double>());
+      pair.fRepNorms.push_back(std::vector<double>());
     }
 
     return;
@@ -337,34 +632,111 @@ namespace flxrd
     // The histograms must be combined BEFORE normalizing,
     // but this should only be done once
     if(!fAlreadyCombined) {
-      CombineAll();
+      for(DetPair& pair : fPairs) {
+        CombineAll(pair);
+        CombineReplicas(pair);
+      }
     }
     fAlreadyCombined = true;
 
-    // Store the number of x axis and y axis bins to loop over
-    const int X = fHists[0]->GetNbinsX();
-    const int Y = fHists[0]->GetNbinsY();
+    // The bins are stored with x varying fastest, so each row of constant y is contiguous,
+    // and every row is scaled by the same per column factors
+    // This includes the underflow and overflow bins of both axes
+    // Every pair uses the same binning
+    const int X = fBinsX.size() + 1;
+    const int Y = fBinsX.size() + 1;
 
-    for(int i_hist = 0, n_hist = fHists.size(); i_hist < n_hist; ++i_hist) {
-      for(int i = 0; i <= X+1; ++i) {
-        for(int j = 0; j <= Y+1; ++j) {
-          // Get the normalization value
-          double detX_norm_value = fNorms[i_hist]->GetBinContent(i);
+    std::vector<double> invNorm(X); // 1/norm, or 0 where the norm is not positive
 
-          // Divide by the normalization value if it is greater than 0
-          if(detX_norm_value > 0) {
-            fHists[i_hist]->SetBinContent(i,j, fHists[i_hist]->GetBinContent(i,j)
-                                              /detX_norm_value);
-          }
-          else { // Otherwise set the bin to 0
-            fHists[i_hist]->SetBinContent(i,j, 0);
-          }
+    for(DetPair& pair : fPairs) {
+      for(int i_hist = 0, n_hist = pair.fHists.size(); i_hist < n_hist; ++i_hist) {
+        const double* norm   = pair.fNorms[i_hist]->GetArray();
+        const double* normE2 = pair.fNorms[i_hist]->GetSumw2()->GetArray();
+
+        for(int i = 0; i < X; ++i) {
+          invNorm[i] = (norm[i] > 0. ? 1./norm[i] : 0.);
+        }
+
+        double*       cont  = pair.fHists[i_hist]->GetArray();
+        double*       e2    = pair.fHists[i_hist]->GetSumw2()->GetArray();
+        const double* cross = pair.fCross[i_hist]->GetArray();
+
+        for(int j = 0; j < Y; ++j) {
+          double*       rowCont  = cont  + j*X;
+          double*       rowE2    = e2    + j*X;
+          const double* rowCross = cross + j*X;
+
+          for(int i = 0; i < X; ++i) {
+            // Every fill of the numerator also fills the norm, so the two are correlated
+            // With a and b the weights of each fill, and r = sum(a)/sum(b):
+            // err^2 = (sum(a^2) - 2 r sum(a b) + r^2 sum(b^2))/sum(b)^2
+            // which is sum((a - r b)^2)/sum(b)^2, and so never negative up to rounding
+            // With equal weights, this is the binomial error r (1 - r)/n
+            const double r = rowCont[i]*invNorm[i];
+            const double err2 = (rowE2[i] - 2.*r*rowCross[i] + r*r*normE2[i])*invNorm[i]*invNorm[i];
+            rowE2  [i] = std::max(err2, 0.);
+            rowCont[i] = r;
+          } // Loop over x axis
         } // Loop over y axis
-      } // Loop over x axis
-    } // Loop over histograms
+
+        // The bins were filled directly, so recalculate the statistics from the normalized contents
+        const double entries = pair.fHists[i_hist]->GetEntries();
+        pair.fHists[i_hist]->ResetStats();
+        pair.fHists[i_hist]->SetEntries(entries);
+      } // Loop over histograms
+    } // Loop over detector pairs
 
     fIsNormalized = true;
 
     return;
   }
+
+  //---------------------------------------------------------------------------
+  void SpectraCorrDet::WriteSpread(const DetPair& pair, int i_hist, TDirectory* out) const
+  {
+    // The spreads go in the bootstrap directory, next to the histograms
+    if(!out->GetDirectory("bootstrap")) {
+      out->mkdir("bootstrap");
+    }
+    TDirectory* dir = out->GetDirectory("bootstrap");
+
+    const int n_rep = fBootstrap->NReplicas();
+    const int X = fBinsX.size() + 1;
+    const int Y = fBinsX.size() + 1;
+
+    const double* repHist = &pair.fRepHists[i_hist][0];
+    const double* repNorm = &pair.fRepNorms[i_hist][0];
+
+    // Same contents as the normalized histogram, with the spread of the normalized replicas as the error
+    TH2D* spread = new TH2D(*pair.fHists[i_hist]);
+    spread->SetDirectory(nullptr);
+    double* e2 = spread->GetSumw2()->GetArray();
+
+    std::vector<double> ratio(n_rep);
+    for(int j = 0; j < Y; ++j) {
+      for(int i = 0; i < X; ++i) {
+        const int cell = j*X + i;
+
+        // Each replica is normalized by its own norm
+        double mean = 0.;
+        for(int i_rep = 0; i_rep < n_rep; ++i_rep) {
+          const double norm = repNorm[i*n_rep + i_rep];
+          ratio[i_rep] = (norm > 0. ? repHist[cell*n_rep + i_rep]/norm : 0.);
+          mean += ratio[i_rep];
+        }
+        mean /= n_rep;
+
+        double sum2 = 0.;
+        for(int i_rep = 0; i_rep < n_rep; ++i_rep) {
+          sum2 += (ratio[i_rep] - mean)*(ratio[i_rep] - mean);
+        }
+        e2[cell] = (n_rep > 1 ? sum2/(n_rep - 1) : 0.);
+      } // Loop over x axis
+    } // Loop over y axis
+
+    dir->WriteTObject(spread);
+    delete spread;
+
+    return;
+  }
 }
@@ -0,0 +1,165 @@
+#include "SpectraMeta.h"
+
+// C/C++ Includes
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+// Root Includes
+#include "TDirectory.h"
+#include "TObjString.h"
+
+namespace flxrd
+{
+  const char* SpectraMeta::kName = "SpectraMeta";
+
+  //---------------------------------------------------------------------------
+  void SpectraMeta::Write(TDirectory* dir) const
+  {
+    TObjString meta(ToString().c_str());
+    dir->WriteTObject(&meta, kName, "Overwrite");
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  bool SpectraMeta::Read(TDirectory* dir)
+  {
+    if(!dir) {
+      return false;
+    }
+
+    TObjString* meta = dynamic_cast<TObjString*>(dir->Get(kName));
+    if(!meta) {
+      return false;
+    }
+
+    bool ok = FromString(meta->GetString().Data());
+    delete meta;
+
+    return ok;
+  }
+
+  //---------------------------------------------------------------------------
+  std::string SpectraMeta::ToString() const
+  {
+    std::ostringstream out;
+    out.precision(std::numeric_limits<double>::max_digits10); // Bin edges must be read back exactly
+
+    out << "version\t"  << kVersion       << '\n';
+    out << "type\t"     << fType          << '\n';
+    out << "dim\t"      << fDim           << '\n';
+    out << "title\t"    << fTitle         << '\n';
+    out << "sign\t"     << fSignSensitive << '\n';
+    out << "ancestor\t" << fAncestorPar   << '\n';
+    out << "pot\t"      << fPOT           << '\n';
+
+    for(const auto& flav : fNuFlavs) {
+      out << "nuflav\t" << flav.first << '\t' << flav.second << '\n';
+    }
+    for(const auto& par : fParents) {
+      out << "parent\t" << par.first << '\t' << par.second << '\n';
+    }
+    for(const auto& xsec : fXSecs) {
+      out << "xsec\t" << xsec << '\n';
+    }
+    for(const auto& det : fDets) {
+      out << "det\t" << det.name << '\t' << det.target << '\t' << det.uses << '\n';
+    }
+
+    // Each axis is its label, followed by its bin edges
+    for(unsigned int i_axis = 0, n_axis = fLabels.size(); i_axis < n_axis; ++i_axis) {
+      out << "axis\t" << fLabels[i_axis];
+      if(i_axis < fBins.size()) {
+        for(const double edge : fBins[i_axis]) {
+          out << '\t' << edge;
+        }
+      }
+      out << '\n';
+    }
+
+    for(const auto& corrDet : fCorrDets) {
+      out << "corrdet\t" << corrDet.first << '\t' << corrDet.second << '\n';
+    }
+
+    for(const auto& pos : fPositions) {
+      out << "position\t" << pos[0] << '\t' << pos[1] << '\t' << pos[2] << '\n';
+    }
+
+    if(fNReplicas > 0) {
+      out << "bootstrap\t" << fNReplicas << '\t' << fBootstrapSeed << '\n';
+    }
+
+    return out.str();
+  }
+
+  //---------------------------------------------------------------------------
+  bool SpectraMeta::FromString(const std::string& str)
+  {
+    *this = SpectraMeta();
+    fVersion = 0; // Only set once the version line is found
+
+    std::istringstream in(str);
+    std::string line;
+    while(std::getline(in, line)) {
+      // Split the line at each tab, keeping empty fields (e.g., an empty axis label)
+      std::vector<std::string> fields;
+      std::istringstream lineStream(line);
+      std::string field;
+      while(std::getline(lineStream, field, '\t')) {
+        fields.push_back(field);
+      }
+
+      if(fields.size() < 2) { continue; }
+
+      const std::string& key = fields[0];
+
+      if     (!key.compare("version" )) { fVersion       = std::atoi(fields[1].c_str()); }
+      else if(!key.compare("type"    )) { fType          = fields[1]; }
+      else if(!key.compare("dim"     )) { fDim           = std::atoi(fields[1].c_str()); }
+      else if(!key.compare("title"   )) { fTitle         = fields[1]; }
+      else if(!key.compare("sign"    )) { fSignSensitive = std::atoi(fields[1].c_str()); }
+      else if(!key.compare("ancestor")) { fAncestorPar   = std::atoi(fields[1].c_str()); }
+      else if(!key.compare("pot"     )) { fPOT           = std::atof(fields[1].c_str()); }
+      else if(!key.compare("nuflav") && fields.size() == 3) {
+        fNuFlavs.push_back(std::make_pair(fields[1], std::atoi(fields[2].c_str())));
+      }
+      else if(!key.compare("parent") && fields.size() == 3) {
+        fParents.push_back(std::make_pair(fields[1], std::atoi(fields[2].c_str())));
+      }
+      else if(!key.compare("xsec")) {
+        fXSecs.push_back(fields[1]);
+      }
+      else if(!key.compare("det") && fields.size() == 4) {
+        fDets.push_back({fields[1], fields[2], (unsigned int)std::atoi(fields[3].c_str())});
+      }
+      else if(!key.compare("axis")) {
+        fLabels.push_back(fields[1]);
+        fBins.push_back(std::vector<double>());
+        for(unsigned int i_field = 2, n_field = fields.size(); i_field < n_field; ++i_field) {
+          fBins.back().push_back(std::atof(fields[i_field].c_str()));
+        }
+      }
+      else if(!key.compare("corrdet") && fields.size() == 3) {
+        fCorrDets.push_back(std::make_pair(fields[1], fields[2]));
+      }
+      else if(!key.compare("position") && fields.size() == 4) {
+        fPositions.push_back({std::atof(fields[1].c_str()), std::atof(fields[2].c_str()), std::atof(fields[3].c_str())});
+      }
+      else if(!key.compare("bootstrap") && fields.size() == 3) {
+        fNReplicas     = std::atoi(fields[1].c_str());
+        fBootstrapSeed = std::strtoull(fields[2].c_str(), nullptr, 10);
+      }
+      // Unknown keys are skipped, so newer files can still be read
+    }
+
+    // A newer format may have changed the meaning of existing fields
+    if(fVersion < 1 || fVersion > kVersion) {
+      std::cout << "Unrecognized SpectraMeta version " << fVersion << "." << std::endl;
+      return false;
+    }
+
+    return fType.length() > 0 && fNuFlavs.size() > 0 && fParents.size() > 0 &&
+           fXSecs.size() > 0 && fDets.size() > 0;
+  }
+}
@@ -0,0 +1,491 @@
+#include "SpectraND.h"
+
+// C/C++ Includes
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+// Root Includes
+#include "TArrayD.h"
+#include "TAxis.h"
+#include "TDirectory.h"
+#include "TH1.h"
+#include "TH1D.h"
+#include "TH2D.h"
+#include "TH3D.h"
+#include "THn.h"
+
+// Package Includes
+#include "Bootstrap.h"
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  template <int N>
+  SpectraND<N>::SpectraND(Parameters params, std::string title,
+                          std::vector<std::string> labels, std::vector<std::vector<double> > bins,
+                          std::vector<Var> vars,
+                          const Weight& wei, TObject* extWeights)
+    : Spectra(params, title, vars.at(0), wei, extWeights),
+      fVars(vars), fLabels(labels), fBins(bins)
+  {
+    assert(N >= 1 && N <= 6); // Only these dimensions are instantiated
+    assert((int)fLabels.size() == N && (int)fBins.size() == N && (int)fVars.size() == N);
+
+    // Variables required by x axis variable and weight are set by Spectra constructor above
+    // Add variables required by the other axes to the list of branches
+    for(int i_axis = 1; i_axis < N; ++i_axis) {
+      fBranches.insert(fVars[i_axis].Branches().begin(), fVars[i_axis].Branches().end());
+    }
+
+    CreateHists(); // Set up the histograms
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  SpectraND<N>::~SpectraND()
+  {
+    for(TObject* h : fHists) {
+      delete h;
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  TH1* SpectraND<N>::GetHist(int i_hist)
+  {
+    if(N > 3) {
+      std::cout << "A " << N << "D Spectra is stored in a THnD; use GetObject." << std::endl;
+      return nullptr;
+    }
+
+    return (TH1*)GetObject(i_hist);
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  TObject* SpectraND<N>::GetObject(int i_hist)
+  {
+    // Check that there actually is a histogram to return
+    const int n_hist = fHists.size();
+    if(i_hist < 0 || i_hist >= n_hist) {
+      std::cout << "Input histogram index is out of range." << std::endl;
+      assert(false);
+    }
+
+    return MakeHist(i_hist);
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  void SpectraND<N>::Fill(bsim::Dk2Nu* nu, std::map<std::string, int> nurayIndices)
+  {
+    // Set the neutrino flavor and parent, and stop if the Parameters do not include them
+    if(!SetCurrentEntry(nu)) {
+      return;
+    }
+
+    for(int i_det = 0, n_det = fParams.NDet(); i_det < n_det; ++i_det) {
+      fParams.SetCurrentDet(i_det);
+
+      // Get the first and last indices in the NuRay vector corresponding to the current detector
+      int first_nuray = nurayIndices[fParams.GetDetName(i_det)];
+      int last_nuray  = first_nuray + fParams.GetDetector(i_det).GetUses();
+
+      // If GetUses returns 0,
+      // this tells FluxReader to not smear the neutrino ray through the detector.
+      // It also means that last_nuray needs to be incremented by 1
+      if(last_nuray == first_nuray) {
+        ++last_nuray;
+      }
+
+      // Histograms for consecutive cross sections are separated by this many master indices
+      const int n_xsec = fParams.NXSec();
+      const int xsec_step = fParams.NFlav()*fParams.NPar();
+
+      fParams.SetCurrentXSec(0);
+      const int first_hist = fParams.GetCurrentMaster(); // Get the histogram index of the first cross section
+
+      for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+        if(fStores[first_hist + i_xsec*xsec_step].fSumw.empty()) { // Allocate the store on its first entry
+          MakeStore(first_hist + i_xsec*xsec_step);
+        }
+      }
+
+      for(int i_nuray = first_nuray; i_nuray < last_nuray; ++i_nuray) {
+        // Calculate the weight for every cross section at once
+        CalcXSecWeights(nu, i_nuray, i_det);
+
+        // The variables and their bins do not depend on the cross section, so only find them once
+        std::array<double, N> vals;
+        int  cell    = 0;
+        bool inRange = true; // ROOT only adds fills inside every axis to the statistics
+        for(int i_axis = 0; i_axis < N; ++i_axis) {
+          vals[i_axis] = fVars[i_axis](nu, i_nuray);
+
+          int bin = FindBin(fBins[i_axis], vals[i_axis]);
+          inRange = inRange && bin > 0 && bin < (int)fBins[i_axis].size();
+          cell += bin*fStrides[i_axis];
+        }
+
+        for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+          Store& store = fStores[first_hist + i_xsec*xsec_step];
+          const double w = fXSecWeights[i_xsec];
+
+          store.fEntries += 1.;
+          store.fWeighted = store.fWeighted || w != 1.;
+          store.fSumw [cell] += w;
+          store.fSumw2[cell] += w*w;
+
+          // Every replica reweights the entry by its own bootstrap weight
+          if(fBootstrap) {
+            const int n_rep = fBootstrap->NReplicas();
+            const double* rw = fBootstrap->Weights();
+            double* rep = &store.fReplicas[cell*n_rep];
+            for(int i_rep = 0; i_rep < n_rep; ++i_rep) {
+              rep[i_rep] += w*rw[i_rep];
+            }
+          }
+
+          if(!inRange) { continue; }
+
+          store.fTsumw  += w;
+          store.fTsumw2 += w*w;
+
+          for(int k = 0, i_cross = 0; k < N; ++k) {
+            store.fTsumwX [k] += w*vals[k];
+            store.fTsumwX2[k] += w*vals[k]*vals[k];
+            for(int j = 0; j < k; ++j, ++i_cross) {
+              store.fTsumwXY[i_cross] += w*vals[j]*vals[k];
+            }
+          }
+        } // Loop over cross sections
+      } // Loop over uses
+    } // Loop over detectors
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  void SpectraND<N>::WriteHists(TDirectory* out)
+  {
+    WriteStores(out);
+
+    // Write the flavor and parent combinations of the histograms that were just written
+    if(fCombine) {
+      if(N <= 3) {
+        std::vector<TH1*> hists(fHists.size(), nullptr);
+        for(unsigned int i_hist = 0, n_hist = fHists.size(); i_hist < n_hist; ++i_hist) {
+          hists[i_hist] = (TH1*)fHists[i_hist];
+        }
+
+        WriteCombinedHists(out, hists);
+      }
+      else {
+        std::cout << fTitle << ": combinations are only written for up to three dimensions." << std::endl;
+      }
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  bool SpectraND<N>::HasStore(int i_hist) const
+  {
+    return !fStores[i_hist].fSumw.empty();
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  TObject* SpectraND<N>::ExistingHist(int i_hist) const
+  {
+    return fHists[i_hist];
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  void SpectraND<N>::MakeStoredHist(int i_hist)
+  {
+    MakeHist(i_hist);
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  void SpectraND<N>::FreeStore(int i_hist, TDirectory* out, const std::string& det_name)
+  {
+    Store& store = fStores[i_hist];
+
+    // The replicas are only summarized once the histogram is complete
+    if(!store.fReplicas.empty()) {
+      WriteSpread(i_hist, out, det_name);
+    }
+
+    std::vector<double>().swap(store.fSumw);
+    std::vector<double>().swap(store.fSumw2);
+    std::vector<double>().swap(store.fReplicas);
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  SpectraMeta SpectraND<N>::MakeMeta() const
+  {
+    SpectraMeta meta = Spectra::MakeMeta();
+
+    meta.fType   = "Spectra" + std::to_string(N) + "D";
+    meta.fDim    = N;
+    meta.fLabels = fLabels;
+    meta.fBins   = fBins;
+
+    if(fBootstrap) {
+      meta.fNReplicas     = fBootstrap->NReplicas();
+      meta.fBootstrapSeed = fBootstrap->Seed();
+    }
+
+    return meta;
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  void SpectraND<N>::CreateHists()
+  {
+    // Bins are numbered like a ROOT histogram: 0 is underflow, and nbins + 1 is overflow
+    fNCells = 1;
+    for(int i_axis = 0; i_axis < N; ++i_axis) {
+      assert(fBins[i_axis].size() >= 2); // Each axis needs at least one bin
+
+      fStrides[i_axis] = fNCells;
+      fNCells *= fBins[i_axis].size() + 1;
+    }
+
+    // Reserve a slot for each Parameters master index
+    // Many combinations never receive an entry, so the stores themselves are made by MakeStore
+    fStores.assign(fParams.MaxMaster(), Store());
+    fHists .assign(fParams.MaxMaster(), nullptr);
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  void SpectraND<N>::MakeStore(int i_hist)
+  {
+    Store& store = fStores[i_hist];
+
+    store.fSumw .assign(fNCells, 0.);
+    store.fSumw2.assign(fNCells, 0.);
+
+    store.fEntries  = 0.;
+    store.fWeighted = false;
+    store.fTsumw    = 0.;
+    store.fTsumw2   = 0.;
+    store.fTsumwX .fill(0.);
+    store.fTsumwX2.fill(0.);
+    store.fTsumwXY.fill(0.);
+
+    if(fBootstrap) {
+      store.fReplicas.assign(fNCells*fBootstrap->NReplicas(), 0.);
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  TObject* SpectraND<N>::MakeHist(int i_hist)
+  {
+    if(!fHists[i_hist]) {
+      // NameTag moves the Parameters indices to i_hist
+      std::string hist_title = fTitle + "_" + fParams.NameTag(i_hist); // This will become the title for writing to file
+
+      std::array<int, N> nBins;
+      for(int i_axis = 0; i_axis < N; ++i_axis) {
+        nBins[i_axis] = fBins[i_axis].size() - 1;
+      }
+
+      if constexpr(N == 1) {
+        std::string axis_label = ";" + fLabels[0] + ";"; // This is the x axis label
+        fHists[i_hist] = new TH1D(hist_title.c_str(), axis_label.c_str(),
+                                  nBins[0], &fBins[0][0]);
+      }
+      else if constexpr(N == 2) {
+        std::string axis_label = ";" + fLabels[0] + ";" + fLabels[1]; // This is the x and y axes labels
+        fHists[i_hist] = new TH2D(hist_title.c_str(), axis_label.c_str(),
+                                  nBins[0], &fBins[0][0], nBins[1], &fBins[1][0]);
+      }
+      else if constexpr(N == 3) {
+        std::string axis_label = ";" + fLabels[0] + ";" + fLabels[1] + ";" + fLabels[2]; // This is all axes labels
+        fHists[i_hist] = new TH3D(hist_title.c_str(), axis_label.c_str(),
+                                  nBins[0], &fBins[0][0], nBins[1], &fBins[1][0], nBins[2], &fBins[2][0]);
+      }
+      else {
+        std::array<double, N> xmin;
+        std::array<double, N> xmax;
+        for(int i_axis = 0; i_axis < N; ++i_axis) {
+          xmin[i_axis] = fBins[i_axis].front();
+          xmax[i_axis] = fBins[i_axis].back();
+        }
+
+        THnD* h = new THnD(hist_title.c_str(), "", N, &nBins[0], &xmin[0], &xmax[0]);
+        for(int i_axis = 0; i_axis < N; ++i_axis) {
+          h->SetBinEdges(i_axis, &fBins[i_axis][0]);
+          h->GetAxis(i_axis)->SetTitle(fLabels[i_axis].c_str());
+        }
+        h->Sumw2();
+
+        fHists[i_hist] = h; // A THnD is never attached to a directory
+      }
+
+      // This Spectra owns the histogram, so it must not belong to the current directory (usually the output file)
+      if constexpr(N <= 3) {
+        ((TH1*)fHists[i_hist])->SetDirectory(nullptr);
+      }
+    }
+
+    // Bring the histogram up to date with anything filled since it was made
+    if(!fStores[i_hist].fSumw.empty()) {
+      CopyStore(fStores[i_hist], fHists[i_hist]);
+    }
+
+    return fHists[i_hist];
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  void SpectraND<N>::CopyStore(const Store& store, TObject* obj) const
+  {
+    if constexpr(N <= 3) {
+      // The store has the same layout as the histogram array
+      TH1* h = (TH1*)obj;
+      TArrayD* arr = dynamic_cast<TArrayD*>(h);
+      assert(arr && arr->GetSize() == fNCells);
+
+      // Squared weights are only stored once a weight other than 1 is filled
+      if(store.fWeighted && h->GetSumw2N() == 0) {
+        h->Sumw2();
+      }
+
+      std::copy(store.fSumw.begin(), store.fSumw.end(), arr->GetArray());
+      if(h->GetSumw2N() > 0) {
+        std::copy(store.fSumw2.begin(), store.fSumw2.end(), h->GetSumw2()->GetArray());
+      }
+
+      // The statistics are ordered as in TH1/TH2/TH3::GetStats:
+      // sumw, sumw2, then for each axis, sumwx, sumwx2, and its products with the previous axes
+      double stats[TH1::kNstat] = {0.};
+      stats[0] = store.fTsumw;
+      stats[1] = store.fTsumw2;
+      for(int k = 0, i_stat = 2, i_cross = 0; k < N; ++k) {
+        stats[i_stat++] = store.fTsumwX [k];
+        stats[i_stat++] = store.fTsumwX2[k];
+        for(int j = 0; j < k; ++j) {
+          stats[i_stat++] = store.fTsumwXY[i_cross++];
+        }
+      }
+
+      h->PutStats(stats);
+      h->SetEntries(store.fEntries);
+    }
+    else {
+      THnD* h = (THnD*)obj;
+
+      // THn numbers its bins differently, so go through the coordinates of each filled bin
+      std::array<int, N> coords;
+      for(int cell = 0; cell < fNCells; ++cell) {
+        if(store.fSumw[cell] == 0. && store.fSumw2[cell] == 0.) { continue; }
+
+        for(int i_axis = 0; i_axis < N; ++i_axis) {
+          coords[i_axis] = (cell/fStrides[i_axis]) % (fBins[i_axis].size() + 1);
+        }
+
+        Long64_t bin = h->GetBin(&coords[0]);
+        h->SetBinContent(bin, store.fSumw[cell]);
+        h->SetBinError2 (bin, store.fSumw2[cell]);
+      }
+
+      h->SetEntries(store.fEntries);
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  template <int N>
+  void SpectraND<N>::WriteSpread(int i_hist, TDirectory* out, const std::string& det_name)
+  {
+    TDirectory* temp = gDirectory;
+
+    // The spreads go in bootstrap/det, next to the detector directories
+    if(!out->GetDirectory("bootstrap")) {
+      out->mkdir("bootstrap");
+    }
+    TDirectory* dir = out->GetDirectory("bootstrap");
+    if(!dir->GetDirectory(det_name.c_str())) {
+      dir->mkdir(det_name.c_str());
+    }
+    dir = dir->GetDirectory(det_name.c_str());
+
+    // Variance of the replicas in each cell
+    const Store& store = fStores[i_hist];
+    const int n_rep = fBootstrap->NReplicas();
+    std::vector<double> var(fNCells, 0.);
+    for(int cell = 0; cell < fNCells; ++cell) {
+      const double* rep = &store.fReplicas[cell*n_rep];
+
+      double mean = 0.;
+      for(int i_rep = 0; i_rep < n_rep; ++i_rep) {
+        mean += rep[i_rep];
+      }
+      mean /= n_rep;
+
+      double sum2 = 0.;
+      for(int i_rep = 0; i_rep < n_rep; ++i_rep) {
+        sum2 += (rep[i_rep] - mean)*(rep[i_rep] - mean);
+      }
+      var[cell] = (n_rep > 1 ? sum2/(n_rep - 1) : 0.);
+    }
+
+    // Same contents as the nominal histogram, with the replica spread as the error
+    TObject* spread = fHists[i_hist]->Clone();
+
+    if constexpr(N <= 3) {
+      TH1* h = (TH1*)spread;
+      if(h->GetSumw2N() == 0) {
+        h->Sumw2();
+      }
+      std::copy(var.begin(), var.end(), h->GetSumw2()->GetArray());
+    }
+    else {
+      THnD* h = (THnD*)spread;
+
+      std::array<int, N> coords;
+      for(int cell = 0; cell < fNCells; ++cell) {
+        if(var[cell] == 0. && store.fSumw[cell] == 0.) { continue; }
+
+        for(int i_axis = 0; i_axis < N; ++i_axis) {
+          coords[i_axis] = (cell/fStrides[i_axis]) % (fBins[i_axis].size() + 1);
+        }
+
+        h->SetBinError2(h->GetBin(&coords[0]), var[cell]);
+      }
+    }
+
+    dir->WriteTObject(spread);
+    delete spread;
+
+    temp->cd();
+    return;
+  }
+
+  // Every supported dimension is instantiated here
+  template class SpectraND<1>;
+  template class SpectraND<2>;
+  template class SpectraND<3>;
+  template class SpectraND<4>;
+  template class SpectraND<5>;
+  template class SpectraND<6>;
+}
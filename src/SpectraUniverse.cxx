@@ -0,0 +1,230 @@
+#include "SpectraUniverse.h"
+
+// C/C++ Includes
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+// Root Includes
+#include "TArrayD.h"
+#include "TDirectory.h"
+#include "TH1.h"
+#include "TH2D.h"
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  SpectraUniverse::SpectraUniverse(Parameters params, std::string title,
+                                   std::string labelx, std::vector<double> binsx, const Var& varx,
+                                   const UniverseWeight& univWei,
+                                   const Weight& wei, TObject* extWeights)
+    : Spectra(params, title, varx, wei, extWeights),
+      fUnivWei(univWei), fLabelX(labelx), fBinsX(binsx)
+  {
+    assert(fBinsX.size() >= 2); // The axis needs at least one bin
+    assert(fUnivWei.NUniv() > 0);
+
+    // Variables required by x axis variable and weight are set by Spectra constructor above
+    // Add variables required by the universe weights to the list of branches
+    fBranches.insert(fUnivWei.Branches().begin(), fUnivWei.Branches().end());
+
+    fNCols = fUnivWei.NUniv() + 1;
+    fUnivValues.assign(fUnivWei.NUniv(), 1.);
+
+    // Reserve a slot for each Parameters master index
+    // Many combinations never receive an entry, so the stores themselves are made by Fill
+    fStores.assign(fParams.MaxMaster(), Store());
+    fHists .assign(fParams.MaxMaster(), nullptr);
+  }
+
+  //---------------------------------------------------------------------------
+  SpectraUniverse::~SpectraUniverse()
+  {
+    for(TH1* h : fHists) {
+      delete h;
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  TH1* SpectraUniverse::GetHist(int i_hist)
+  {
+    // Check that there actually is a histogram to return
+    const int n_hist = fHists.size();
+    if(i_hist < 0 || i_hist >= n_hist) {
+      std::cout << "Input histogram index is out of range." << std::endl;
+      assert(false);
+    }
+
+    return MakeHist(i_hist);
+  }
+
+  //---------------------------------------------------------------------------
+  void SpectraUniverse::Fill(bsim::Dk2Nu* nu, std::map<std::string, int> nurayIndices)
+  {
+    // Set the neutrino flavor and parent, and stop if the Parameters do not include them
+    if(!SetCurrentEntry(nu)) {
+      return;
+    }
+
+    const int n_univ = fUnivWei.NUniv();
+    const int n_cols = fNCols;
+
+    for(int i_det = 0, n_det = fParams.NDet(); i_det < n_det; ++i_det) {
+      fParams.SetCurrentDet(i_det);
+
+      // Get the first and last indices in the NuRay vector corresponding to the current detector
+      int first_nuray = nurayIndices[fParams.GetDetName(i_det)];
+      int last_nuray  = first_nuray + fParams.GetDetector(i_det).GetUses();
+
+      // A detector with 0 uses still has one neutrino ray
+      if(last_nuray == first_nuray) {
+        ++last_nuray;
+      }
+
+      // Histograms for consecutive cross sections are separated by this many master indices
+      const int n_xsec = fParams.NXSec();
+      const int xsec_step = fParams.NFlav()*fParams.NPar();
+
+      fParams.SetCurrentXSec(0);
+      const int first_hist = fParams.GetCurrentMaster(); // Get the histogram index of the first cross section
+
+      for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+        Store& store = fStores[first_hist + i_xsec*xsec_step];
+        if(store.fSumw.empty()) { // Allocate the store on its first entry
+          store.fSumw .assign((fBinsX.size() + 1)*n_cols, 0.);
+          store.fSumw2.assign((fBinsX.size() + 1)*n_cols, 0.);
+          store.fEntries = 0.;
+        }
+      }
+
+      for(int i_nuray = first_nuray; i_nuray < last_nuray; ++i_nuray) {
+        // The nominal weights, variable, bin, and universe weights are shared by every universe
+        CalcXSecWeights(nu, i_nuray, i_det);
+
+        const int bin = FindBin(fBinsX, fVarX(nu, i_nuray));
+
+        fUnivWei(nu, i_nuray, fExtWeights, &fUnivValues[0]);
+        const double* univ = &fUnivValues[0];
+
+        for(int i_xsec = 0; i_xsec < n_xsec; ++i_xsec) {
+          Store& store = fStores[first_hist + i_xsec*xsec_step];
+          const double w = fXSecWeights[i_xsec];
+
+          store.fEntries += 1.;
+
+          // The nominal weight is the first column, followed by the contiguous universes
+          double* sumw  = &store.fSumw [bin*n_cols];
+          double* sumw2 = &store.fSumw2[bin*n_cols];
+          sumw [0] += w;
+          sumw2[0] += w*w;
+
+          for(int i_univ = 0; i_univ < n_univ; ++i_univ) {
+            const double wu = w*univ[i_univ];
+            sumw [i_univ + 1] += wu;
+            sumw2[i_univ + 1] += wu*wu;
+          }
+        } // Loop over cross sections
+      } // Loop over uses
+    } // Loop over detectors
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void SpectraUniverse::WriteHists(TDirectory* out)
+  {
+    WriteStores(out);
+
+    // Every universe is combined along with the nominal histogram
+    if(fCombine) {
+      WriteCombinedHists(out, fHists);
+    }
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  bool SpectraUniverse::HasStore(int i_hist) const
+  {
+    return !fStores[i_hist].fSumw.empty();
+  }
+
+  //---------------------------------------------------------------------------
+  TObject* SpectraUniverse::ExistingHist(int i_hist) const
+  {
+    return fHists[i_hist];
+  }
+
+  //---------------------------------------------------------------------------
+  void SpectraUniverse::MakeStoredHist(int i_hist)
+  {
+    MakeHist(i_hist);
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  void SpectraUniverse::FreeStore(int i_hist, TDirectory* out, const std::string& det_name)
+  {
+    std::vector<double>().swap(fStores[i_hist].fSumw);
+    std::vector<double>().swap(fStores[i_hist].fSumw2);
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  SpectraMeta SpectraUniverse::MakeMeta() const
+  {
+    SpectraMeta meta = Spectra::MakeMeta();
+
+    std::vector<double> univEdges;
+    for(int i_col = 0; i_col <= fNCols; ++i_col) {
+      univEdges.push_back(i_col - 1.);
+    }
+
+    meta.fType   = "SpectraUniverse";
+    meta.fDim    = 2;
+    meta.fLabels = {fLabelX, "Universe"};
+    meta.fBins   = {fBinsX, univEdges};
+
+    return meta;
+  }
+
+  //---------------------------------------------------------------------------
+  TH1* SpectraUniverse::MakeHist(int i_hist)
+  {
+    const int nx = fBinsX.size() - 1;
+
+    if(!fHists[i_hist]) {
+      // NameTag moves the Parameters indices to i_hist
+      std::string hist_title = fTitle + "_" + fParams.NameTag(i_hist);
+      std::string axis_label = ";" + fLabelX + ";Universe (-1 is nominal)";
+
+      // Universe i_univ is the bin from i_univ to i_univ + 1, after the nominal bin from -1 to 0
+      fHists[i_hist] = new TH2D(hist_title.c_str(), axis_label.c_str(),
+                                nx, &fBinsX[0], fNCols, -1., fNCols - 1.);
+      fHists[i_hist]->SetDirectory(nullptr); // Owned by this Spectra, not by the current directory
+      fHists[i_hist]->Sumw2();
+    }
+
+    const Store& store = fStores[i_hist];
+    if(!store.fSumw.empty()) {
+      // The store is [bin][universe], while ROOT keeps the universe (y) bins apart by nx + 2 cells
+      TH1* h = fHists[i_hist];
+      double* contents = dynamic_cast<TArrayD*>(h)->GetArray();
+      double* errors   = h->GetSumw2()->GetArray();
+
+      for(int i_bin = 0; i_bin < nx + 2; ++i_bin) {
+        for(int i_col = 0; i_col < fNCols; ++i_col) {
+          const int cell = i_bin + (nx + 2)*(i_col + 1);
+          contents[cell] = store.fSumw [i_bin*fNCols + i_col];
+          errors  [cell] = store.fSumw2[i_bin*fNCols + i_col];
+        }
+      }
+
+      h->ResetStats(); // Recalculate the statistics from the new contents
+      h->SetEntries(store.fEntries);
+    }
+
+    return fHists[i_hist];
+  }
+}
@@ -0,0 +1,2 @@
+#include "UniverseWeight.h"
+// This include forces the code in "UniverseWeight.h" to get built during compilation
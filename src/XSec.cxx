@@ -1,9 +1,14 @@
 #include "XSec.h"
 
 // C/C++ Includes
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <mutex>
 #include <stdlib.h>
+#include <vector>
 
 // Root Includes
 #include "TAxis.h"
@@ -12,19 +17,40 @@
 #include "TGraph.h"
 #include "TH1.h"
 #include "TKey.h"
+#include "TMD5.h"
 #include "TSpline.h"
+#include "TSystem.h"
 
 // Package Includes
 #include "Utilities.h"
 
 namespace flxrd
 {
+  namespace
+  {
+    /// Valid inputs read from one cross section file
+    struct ValidInputs
+    {
+      std::set<std::string> intType;
+      std::map<int, std::string> nuPDG;
+      std::map<std::string, std::string> target;
+    };
+
+    /// Process-wide catalog of the valid inputs of each cross section file, keyed by file name
+    std::map<std::string, ValidInputs> gValidInputs;
+    std::mutex gValidInputsMutex;
+  }
+
   //----------------------------------------------------------------------
   XSec::XSec()
   {
     fLocalDir = gDirectory;
     fXSecFile = new TFile();
 
+    // Use the on-disk graph cache if a directory has been given
+    const char* cacheDir = std::getenv("FLXRD_XSECCACHE");
+    fCacheDir = (cacheDir ? cacheDir : "");
+
     SetXSecFile(); // Initialize the file
 
     // Source: http://www.chemeddl.org/resources/ptl/index.php
@@ -45,12 +71,41 @@ namespace flxrd
     if(fXSecFile->IsOpen()) {
       fXSecFile->Close();
     }
+
+    ClearCache();
   }
 
   //----------------------------------------------------------------------
   TGraph* XSec::GetGraph(int pdg, std::string tar, std::string type, bool eventRate)
   {
-    TGraph* gRet = new TGraph();
+    std::string key = CacheKey(pdg, tar, type, eventRate);
+
+    // Derive each graph only the first time it is requested
+    if(fGraphs.find(key) == fGraphs.end()) {
+      // Compound and event rate graphs are derived; base graphs are read straight from the file
+      bool derived = (eventRate || fTarget.find(tar) == fTarget.end());
+
+      TGraph* g = (derived ? ReadCachedGraph(key) : nullptr); // Check the on-disk cache first
+
+      if(!g) {
+        g = MakeGraph(pdg, tar, type, eventRate);
+
+        if(derived) {
+          WriteCachedGraph(key, g);
+        }
+      }
+
+      fGraphs[key] = g;
+    }
+
+    // Return a copy, so the caller can modify or delete it
+    return (TGraph*)fGraphs[key]->Clone();
+  }
+
+  //----------------------------------------------------------------------
+  TGraph* XSec::MakeGraph(int pdg, std::string tar, std::string type, bool eventRate)
+  {
+    TGraph* gRet = nullptr;
 
     // Copy this string into a local variable that can be passed by reference
     std::string typeCopy(type);
@@ -71,7 +126,7 @@ namespace flxrd
     // If this cross section is for an event rate, scale the y values appropriately
     if(eventRate) {
       // Avogadro's Number * 10^-38 cm^2 * 10^9 g/kton / Molar Mass
-      double scale = 0.0000060221413/fMolarMass[tar]; // Units: cm^2/kton
+      double scale = 0.0000060221413/GetMolarMass(tar); // Units: cm^2/kton
 
       // Scale each y value
       double x = 0., y = 0.;
@@ -108,7 +163,7 @@ namespace flxrd
     // For ratios, the scale for event rates is just the inverse ratio of the two molar masses
     double eventRateScale = 1.;
     if(eventRate) {
-      eventRateScale = fMolarMass[tar2]/fMolarMass[tar1];
+      eventRateScale = GetMolarMass(tar2)/GetMolarMass(tar1);
     }
 
     for(int i = 0; i < n; ++i) {
@@ -128,6 +183,9 @@ namespace flxrd
       }
     }
 
+    delete g1;
+    delete g2;
+
     TGraph* gRet = new TGraph(n, x, yRet); // Create the new graph
 
     // The interaction type passed to MakeXSecRatioTitle must be modified separately
@@ -154,6 +212,8 @@ namespace flxrd
 
     s->SetTitle(g->GetTitle()); // This should pick up the actual title and axes labels
 
+    delete g; // The spline keeps its own copy of the points
+
     return s;
   }
 
@@ -170,110 +230,47 @@ namespace flxrd
 
     s->SetTitle(g->GetTitle()); // This should pick up the actual title and axes labels
 
+    delete g; // The spline keeps its own copy of the points
+
     return s;
   }
 
   //----------------------------------------------------------------------
-  TH1* XSec::GetHist(TSpline3* s, int nbins, double xmin, double xmax)
+  TH1* XSec::GetHist(TSpline3* s, int nbins, double xmin, double xmax, double precision)
   {
     TH1* ret = new TH1D("", "", nbins, xmin, xmax);
 
-    TAxis* ax = ret->GetXaxis();
-
-    double bin_val = 0.; // This value will be assigned to a histogram bin 
-    double delta_x = (xmax - xmin)/(10.*(double)nbins); // Width of (most) discrete integral trapezoids
-    if(delta_x > 0.1) { // Max width of discrete integral trapezoids
-      delta_x = 0.1;
-    }
-
-    for(int i = 1; i <= nbins; ++i) {
-      // Calculate bin average from discrete integral over bin width
-      // Calculate discrete integral of spline through current bin using trapezoids
-      // Integral I(f(x), a, b) = delta_x * { [f(0) + f(N)]/2 + f(1) + f(2) + ... f(N-1) }, x(0) = a, x(N) = b
-      if(delta_x < 0.1) { // Calculate discrete integral breaking up bin into 10 equal parts
-        for(int i_x = 1; i_x < 10; i_x++) {
-          bin_val += XSecEval(s, ax->GetBinLowEdge(i) + i_x*delta_x); // Adding f(1) through f(N-1)
-        }
-
-        bin_val += 0.5*( XSecEval(s, ax->GetBinLowEdge(i)) + XSecEval(s, ax->GetBinUpEdge(i)) ); // Add [f(0) and f(N)]/2
-        bin_val *= delta_x; // Multiply by delta_x
-        bin_val /= (ax->GetBinUpEdge(i) - ax->GetBinLowEdge(i)); // Compute average
-      }
-      else { // Calculate using trapezoids of width 0.1 GeV as is possible, use smaller width for last trapezoid
-        int num_eval_pts = (ax->GetBinUpEdge(i) - ax->GetBinLowEdge(i))*10;
-        double max_loop_x = ax->GetBinLowEdge(i) + num_eval_pts*delta_x;
-
-        for(int i_x = 1; i_x < num_eval_pts; i_x++) {
-          bin_val += s->Eval(ax->GetBinLowEdge(i) + i_x*delta_x);
-        }
-
-        bin_val += 0.5*(XSecEval(s, ax->GetBinLowEdge(i)) + XSecEval(s, max_loop_x));
-        bin_val *= delta_x;
-
-        bin_val += 0.5*(ax->GetBinUpEdge(i) - max_loop_x)
-                      *(XSecEval(s, max_loop_x) + XSecEval(s, ax->GetBinUpEdge(i)));
-
-        bin_val /= (ax->GetBinUpEdge(i) - ax->GetBinLowEdge(i));
-      }
-
-      ret->SetBinContent(i, bin_val); // Set bin content to histogram bin
-      bin_val = 0; // Reset bin value calculation variable
-    } // Loop over histogram bins
+    FillBinAverages(s, ret, precision);
 
     ret->SetTitle(s->GetTitle()); // This should pick up the actual title and y axis label (if applicable)
     return ret;
   }
 
   //----------------------------------------------------------------------
-  TH1* XSec::GetHist(TSpline3* s, int nbins, const double* edges)
+  TH1* XSec::GetHist(TSpline3* s, int nbins, const double* edges, double precision)
   {
-    // This function is similar to the equally spaced bins version above
-    // See its comments for more details
-
     TH1* ret = new TH1D("", "", nbins, edges);
 
-    TAxis* ax = ret->GetXaxis();
-
-    double bin_val = 0.;
-    double delta_x = 0.1;
-
-    for(int i = 1; i <= nbins; ++i) {
-      delta_x = (ax->GetBinUpEdge(i) - ax->GetBinLowEdge(i))/10.;
-
-      if(delta_x < 0.1) {
-        for(int i_x = 1; i_x < 10; i_x++) {
-          bin_val += XSecEval(s, (ax->GetBinLowEdge(i) + i_x*delta_x) );
-        }
-
-        bin_val += 0.5*(XSecEval(s, ax->GetBinLowEdge(i)) + XSecEval(s, ax->GetBinUpEdge(i)));
-        bin_val *= delta_x;
-        bin_val /= ax->GetBinUpEdge(i) - ax->GetBinLowEdge(i);
-      }
-      else {
-        delta_x = 0.1;
-
-        int num_eval_pts = (ax->GetBinUpEdge(i) - ax->GetBinLowEdge(i))*10;
-        double max_loop_x = ax->GetBinLowEdge(i) + num_eval_pts*delta_x;
+    FillBinAverages(s, ret, precision);
 
-        for(int i_x = 1; i_x < num_eval_pts; i_x++) {
-          bin_val += XSecEval(s, ax->GetBinLowEdge(i) + i_x*delta_x);
-        }
-
-        bin_val += 0.5*(XSecEval(s, ax->GetBinLowEdge(i)) + XSecEval(s, max_loop_x));
-        bin_val *= delta_x;
-
-        bin_val += 0.5*(ax->GetBinUpEdge(i) - max_loop_x)
-                      *(XSecEval(s, max_loop_x) + XSecEval(s, ax->GetBinUpEdge(i)));
+    ret->SetTitle(s->GetTitle()); // This should pick up the actual title and y axis label (if applicable)
+    return ret;
+  }
 
-        bin_val /= ax->GetBinUpEdge(i) - ax->GetBinLowEdge(i);
+  //----------------------------------------------------------------------
+  double XSec::GetMolarMass(std::string tar)
+  {
+    // Compounds are computed from their constituent atoms the first time they are needed
+    if(fMolarMass.find(tar) == fMolarMass.end() && fTarget.find(tar) == fTarget.end()) {
+      double molarMass = 0.;
+      for(const auto& tarPair : ParseCompound(tar)) {
+        molarMass += (double)tarPair.second*fMolarMass[tarPair.first];
       }
 
-      ret->SetBinContent(i, bin_val);
-      bin_val = 0.;
-    } // Loop over histogram bins
+      fMolarMass[tar] = molarMass;
+    }
 
-    ret->SetTitle(s->GetTitle()); // This should pick up the actual title and y axis label (if applicable)
-    return ret;
+    return fMolarMass[tar];
   }
 
   //----------------------------------------------------------------------
@@ -326,6 +323,15 @@ namespace flxrd
     return;
   }
 
+  //----------------------------------------------------------------------
+  void XSec::SetCacheDir(std::string dir)
+  {
+    fCacheDir   = dir;
+    fCacheStamp = ""; // Recompute the file stamp the next time it is needed
+
+    return;
+  }
+
   //----------------------------------------------------------------------
   void XSec::SetXSecFile(std::string override)
   {
@@ -376,7 +382,12 @@ namespace flxrd
       xsecFileName = override;
     }
 
+    // Graphs derived from a previous file are no longer valid
+    ClearCache();
+    fCacheStamp = "";
+
     fXSecFile = new TFile(xsecFileName.c_str(), "READ");
+    fXSecFileName = xsecFileName;
     if(fXSecFile->IsOpen()) {
       SetupValidInputs();
     }
@@ -388,6 +399,119 @@ namespace flxrd
     return;
   }
 
+  //----------------------------------------------------------------------
+  void XSec::FillBinAverages(TSpline3* s, TH1* h, double precision)
+  {
+    TAxis* ax = h->GetXaxis();
+
+    for(int i = 1, n = ax->GetNbins(); i <= n; ++i) {
+      double low  = ax->GetBinLowEdge(i);
+      double high = ax->GetBinUpEdge(i);
+
+      // Bin average is the integral over the bin divided by the bin width
+      h->SetBinContent(i, IntegratePositive(s, low, high, precision)/(high - low));
+    } // Loop over histogram bins
+
+    return;
+  }
+
+  //----------------------------------------------------------------------
+  double XSec::IntegratePositive(TSpline3* s, double xmin, double xmax, double precision)
+  {
+    const int n_knot = s->GetNp();
+    if(n_knot < 2) { // Not enough knots for a polynomial; use the value at the center
+      double val = s->Eval(0.5*(xmin + xmax));
+      return (val > 0. ? val : 0.)*(xmax - xmin);
+    }
+
+    double ret = 0.;
+
+    // Use the same segment as TSpline3::Eval: the first one below the first knot,
+    // and the second to last one above the last knot
+    int i_knot = s->FindX(xmin);
+    if(i_knot >= n_knot - 1) { i_knot = n_knot - 2; }
+    if(i_knot < 0)           { i_knot = 0; }
+
+    double knot = 0., y = 0., b = 0., c = 0., d = 0.;
+    double next = 0., temp = 0.;
+
+    double low = xmin;
+    while(low < xmax) {
+      // The segment polynomial is p(t) = y + b*t + c*t^2 + d*t^3, with t = x - knot
+      s->GetCoeff(i_knot, knot, y, b, c, d);
+
+      // The last segment extends to infinity
+      double high = xmax;
+      if(i_knot < n_knot - 2) {
+        s->GetKnot(i_knot + 1, next, temp);
+        if(next < high) { high = next; }
+      }
+
+      // Split the segment at the critical points of p, so p is monotonic on each piece
+      double t[4] = { low - knot, 0., 0., high - knot };
+      int n_t = 1;
+
+      double crit[2] = { 0., 0. };
+      int n_crit = 0;
+      if(d != 0.) {
+        double disc = c*c - 3.*b*d;
+        if(disc > 0.) {
+          crit[0] = (-c - std::sqrt(disc))/(3.*d);
+          crit[1] = (-c + std::sqrt(disc))/(3.*d);
+          if(crit[0] > crit[1]) { std::swap(crit[0], crit[1]); }
+          n_crit = 2;
+        }
+      }
+      else if(c != 0.) {
+        crit[0] = -b/(2.*c);
+        n_crit = 1;
+      }
+
+      for(int i_crit = 0; i_crit < n_crit; ++i_crit) {
+        if(crit[i_crit] > t[n_t - 1] && crit[i_crit] < t[3]) {
+          t[n_t++] = crit[i_crit];
+        }
+      }
+      t[n_t++] = t[3];
+
+      // On each monotonic piece, p has at most one root
+      // Find it by bisection, and integrate only where p is positive
+      for(int i_t = 0; i_t < n_t - 1; ++i_t) {
+        double t0 = t[i_t];
+        double t1 = t[i_t + 1];
+
+        double p0 = y + t0*(b + t0*(c + t0*d));
+        double p1 = y + t1*(b + t1*(c + t1*d));
+
+        if(p0 <= 0. && p1 <= 0.) { continue; }
+
+        if(p0 < 0. || p1 < 0.) {
+          double neg = (p0 < 0. ? t0 : t1);
+          double pos = (p0 < 0. ? t1 : t0);
+
+          for(int i_iter = 0; i_iter < 200 && std::fabs(pos - neg) > precision; ++i_iter) {
+            double mid = 0.5*(neg + pos);
+            if(y + mid*(b + mid*(c + mid*d)) > 0.) { pos = mid; }
+            else                                   { neg = mid; }
+          }
+
+          // Keep the positive side of the root
+          if(p0 < 0.) { t0 = pos; }
+          else        { t1 = pos; }
+        }
+
+        // Antiderivative of p is y*t + b*t^2/2 + c*t^3/3 + d*t^4/4
+        ret += (t1*(y + t1*(b/2. + t1*(c/3. + t1*d/4.))))
+             - (t0*(y + t0*(b/2. + t0*(c/3. + t0*d/4.))));
+      }
+
+      low = high;
+      ++i_knot;
+    } // Loop over spline segments
+
+    return ret;
+  }
+
   //----------------------------------------------------------------------
   double XSec::XSecEval(TSpline3* s, double x)
   {
@@ -395,6 +519,70 @@ namespace flxrd
     return xsec;
   }
 
+  //----------------------------------------------------------------------
+  void XSec::XSecEval(TSpline3* s, int n, const double* x, double* vals, bool sorted)
+  {
+    const int n_knot = s->GetNp();
+    if(n_knot < 2) { // Not enough knots for a polynomial
+      for(int i = 0; i < n; ++i) {
+        vals[i] = s->Eval(x[i]);
+        vals[i] = (vals[i] > 0. ? vals[i] : 0.);
+      }
+      return;
+    }
+
+    // Copy the knots and polynomial coefficients into flat arrays
+    std::vector<double> knots(n_knot), y(n_knot), b(n_knot), c(n_knot), d(n_knot);
+    for(int i_knot = 0; i_knot < n_knot; ++i_knot) {
+      s->GetCoeff(i_knot, knots[i_knot], y[i_knot], b[i_knot], c[i_knot], d[i_knot]);
+    }
+
+    // Find the segment for each point, using the same segment as TSpline3::Eval:
+    // the first one below the first knot, and the second to last one above the last knot
+    std::vector<int> seg(n);
+    if(sorted) {
+      int i_knot = 0;
+      for(int i = 0; i < n; ++i) {
+        while(i_knot < n_knot - 2 && x[i] > knots[i_knot + 1]) {
+          ++i_knot;
+        }
+        seg[i] = i_knot;
+      }
+    }
+    else {
+      for(int i = 0; i < n; ++i) {
+        int i_knot = (std::lower_bound(knots.begin(), knots.end(), x[i]) - knots.begin()) - 1;
+        if(i_knot < 0)           { i_knot = 0; }
+        if(i_knot > n_knot - 2)  { i_knot = n_knot - 2; }
+        seg[i] = i_knot;
+      }
+    }
+
+    // Evaluate the polynomials, then clamp, in separate loops without branches on the segment
+    for(int i = 0; i < n; ++i) {
+      const int k = seg[i];
+      const double dx = x[i] - knots[k];
+      vals[i] = y[k] + dx*(b[k] + dx*(c[k] + dx*d[k]));
+    }
+
+    for(int i = 0; i < n; ++i) {
+      vals[i] = (vals[i] > 0. ? vals[i] : 0.);
+    }
+
+    return;
+  }
+
+  //----------------------------------------------------------------------
+  std::vector<double> XSec::XSecEval(TSpline3* s, const std::vector<double>& x, bool sorted)
+  {
+    std::vector<double> vals(x.size(), 0.);
+    if(!x.empty()) {
+      XSecEval(s, x.size(), &x[0], &vals[0], sorted);
+    }
+
+    return vals;
+  }
+
   //----------------------------------------------------------------------
   void XSec::AddElementToCompoundMap(std::string tar, int number,
                                      std::map<std::string, int>* map)
@@ -427,6 +615,51 @@ namespace flxrd
   //----------------------------------------------------------------------
   TGraph* XSec::GetGraphCompound(std::string compound, int pdg, std::string type)
   {
+    std::vector<double> x;    // Array of x values
+    std::vector<double> yTot; // The final y values array
+    double y = 0.; // Temp variables for the y value of each graph point
+
+    // Loop over each target/number of atoms pair
+    for(const auto& tarPair : ParseCompound(compound)) {
+      std::string tar = tarPair.first;
+
+      // Get the relevant base graph
+      TGraph* g = GetGraph(pdg, tar, type);
+
+      // Get the number of points in each graph, initializing the arrays with the first one
+      const int n = g->GetN();
+      if(x.empty()) {
+        x   .assign(n, 0.);
+        yTot.assign(n, 0.);
+      }
+      assert(n == (int)x.size());
+
+      // Cast the coefficient of the current target as a double
+      double coeff = (double)tarPair.second;
+
+      // Loop over each point in the current graph
+      for(int i = 0; i < n; ++i) {
+        // Get the point, add it to the running total with the proper coefficient
+        g->GetPoint(i, x[i], y);
+        yTot[i] += coeff*y;
+      } // end of loop over points in the current graph
+
+      delete g;
+    } // end of for loop over each target pair
+
+    // Create the graph to be returned
+    TGraph* gRet = new TGraph(x.size(), &x[0], &yTot[0]);
+    return gRet;
+  }
+
+  //----------------------------------------------------------------------
+  const std::map<std::string, int>& XSec::ParseCompound(std::string compound)
+  {
+    // Each compound only needs to be parsed once
+    if(fCompounds.find(compound) != fCompounds.end()) {
+      return fCompounds[compound];
+    }
+
     // Character sets for string tokenization
     std::string upperCase = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
     std::string lowerCase = "abcdefghijklmnopqrstuvwxyz";
@@ -511,46 +744,114 @@ namespace flxrd
       abort();
     }
 
-    // Get the number of points in each graph
-    const int n = GetGraph(pdg, targetsByNumber.begin()->first, type)->GetN();
-    double x[n]; // Array of x values
-    double y = 0.; // Temp variables for the y value of each graph point
-    double yTot[n]; // The final y values array
+    fCompounds[compound] = targetsByNumber;
+    return fCompounds[compound];
+  }
 
-    double molarMass = 0.; // Molar mass of the compound
+  //----------------------------------------------------------------------
+  std::string XSec::CacheKey(int pdg, std::string tar, std::string type, bool eventRate) const
+  {
+    return std::to_string(pdg) + "_" + tar + "_" + type + (eventRate ? "_rate" : "");
+  }
 
-    // Initialize arrays
-    for(int i = 0; i < n; ++i) {
-      x[i] = 0.;
-      yTot[i] = 0.;
+  //----------------------------------------------------------------------
+  std::string XSec::CacheFileName(std::string key)
+  {
+    if(fCacheDir.empty()) {
+      return "";
     }
 
-    // Loop over each target/number of atoms pair
-    for(const auto& tarPair : targetsByNumber) {
-      std::string tar = tarPair.first;
+    // The cross section file is identified by its path, size, and modification time,
+    // which only needs a stat, instead of a checksum of the whole file
+    if(fCacheStamp.empty()) {
+      Long_t id = 0, flags = 0, modTime = 0;
+      Long64_t size = 0;
+      if(gSystem->GetPathInfo(fXSecFileName.c_str(), &id, &size, &flags, &modTime) != 0) {
+        std::cout << "Warning: could not find the size and time of " << fXSecFileName << "." << std::endl
+                  << "The on-disk cross section cache will not be used." << std::endl;
+        fCacheDir = "";
+        return "";
+      }
 
-      // Get the relevant base graph
-      TGraph* g = GetGraph(pdg, tar, type);
+      std::string stamp = fXSecFileName + "\t" + std::to_string(size) + "\t" + std::to_string(modTime);
 
-      // Cast the coefficient of the current target as a double
-      double coeff = (double)tarPair.second;
+      TMD5 md5;
+      md5.Update((const unsigned char*)stamp.c_str(), stamp.size());
+      md5.Final();
+      fCacheStamp = md5.AsString();
+    }
 
-      // Loop over each point in the current graph
-      for(int i = 0; i < n; ++i) {
-        // Get the point, add it to the running total with the proper coefficient
-        g->GetPoint(i, x[i], y);
-        yTot[i] += coeff*y;
-      } // end of loop over points in the current graph
+    return fCacheDir + "/xsec_cache_" + fCacheStamp + "_" + key + ".root";
+  }
 
-      molarMass += coeff*fMolarMass[tar];
-    } // end of for loop over each target pair
+  //----------------------------------------------------------------------
+  TGraph* XSec::ReadCachedGraph(std::string key)
+  {
+    std::string fileName = CacheFileName(key);
 
-    // Otherwise, add the molar mass to the map
-    fMolarMass[compound] = molarMass;
+    // AccessPathName returns true if the file does NOT exist
+    if(fileName.empty() || gSystem->AccessPathName(fileName.c_str())) {
+      return nullptr;
+    }
 
-    // Create the graph to be returned
-    TGraph* gRet = new TGraph(n, x, yTot);
-    return gRet;
+    TDirectory* tmp = gDirectory;
+
+    TGraph* g = nullptr;
+    TFile* f = TFile::Open(fileName.c_str(), "READ");
+    if(f && f->IsOpen()) {
+      g = (TGraph*)f->Get(key.c_str());
+      f->Close();
+    }
+    delete f;
+
+    tmp->cd();
+    return g;
+  }
+
+  //----------------------------------------------------------------------
+  void XSec::WriteCachedGraph(std::string key, TGraph* g)
+  {
+    std::string fileName = CacheFileName(key);
+
+    // Another job may have written the graph since it was looked for; it is the same graph
+    if(fileName.empty() || !gSystem->AccessPathName(fileName.c_str())) {
+      return;
+    }
+
+    TDirectory* tmp = gDirectory;
+
+    // Write a file private to this process, and move it into place in one step,
+    // so other jobs either see no file or the complete one
+    std::string tempName = fileName + ".tmp" + std::to_string(gSystem->GetPid());
+
+    bool written = false;
+    TFile* f = TFile::Open(tempName.c_str(), "RECREATE");
+    if(f && f->IsOpen()) {
+      written = (f->WriteTObject(g, key.c_str()) > 0);
+      f->Close();
+    }
+    delete f;
+
+    if(!written || std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+      std::cout << "Warning: could not write to the cross section cache " << fileName << "." << std::endl;
+      gSystem->Unlink(tempName.c_str());
+    }
+
+    tmp->cd();
+    return;
+  }
+
+  //----------------------------------------------------------------------
+  void XSec::ClearCache()
+  {
+    for(auto& graph : fGraphs) {
+      delete graph.second;
+    }
+
+    fGraphs.clear();
+    fCompounds.clear();
+
+    return;
   }
 
   //----------------------------------------------------------------------
@@ -647,6 +948,17 @@ namespace flxrd
   //----------------------------------------------------------------------
   void XSec::SetupValidInputs()
   {
+    std::lock_guard<std::mutex> lock(gValidInputsMutex);
+
+    // Reuse the catalog if this file has already been read
+    auto it = gValidInputs.find(fXSecFileName);
+    if(it != gValidInputs.end()) {
+      fIntType = it->second.intType;
+      fNuPDG   = it->second.nuPDG;
+      fTarget  = it->second.target;
+      return;
+    }
+
     fIntType.clear();
     fNuPDG.clear();
     fTarget.clear();
@@ -723,6 +1035,12 @@ namespace flxrd
       fIntType.insert("ve_ccncmix");
     }
 
+    // Store the inputs for every later XSec object using this file
+    ValidInputs& inputs = gValidInputs[fXSecFileName];
+    inputs.intType = fIntType;
+    inputs.nuPDG   = fNuPDG;
+    inputs.target  = fTarget;
+
     tmp->cd();
 
     return;
@@ -0,0 +1,240 @@
+#include "XSecFolder.h"
+
+// C/C++ Includes
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Root Includes
+#include "TArrayD.h"
+#include "TAxis.h"
+#include "TCollection.h"
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TH1.h"
+#include "TKey.h"
+#include "TSpline.h"
+
+// Package Includes
+#include "Detector.h"
+#include "ParticleParam.h"
+#include "SpectraMeta.h"
+#include "XSec.h"
+#include "XSecRegistry.h"
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  XSecFolder::XSecFolder(std::string out)
+  {
+    // Store current directory to come back to later
+    TDirectory* temp = gDirectory;
+
+    fOut = new TFile(out.c_str(), "UPDATE"); // Open the input file
+    assert(fOut->IsOpen()); // Break if the file is unopened
+
+    temp->cd(); // Go back to original directory
+  }
+
+  //---------------------------------------------------------------------------
+  XSecFolder::~XSecFolder()
+  {
+    if(fOut) {
+      fOut->Close();
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  int XSecFolder::Fold(std::string spec, const Detector& det, std::string xsec, double precision)
+  {
+    if(!XSecRegistry::Instance().IsValidProcess(xsec)) {
+      std::cout << "The input cross section " << xsec << " is not valid." << std::endl;
+      return 0;
+    }
+
+    // The flux histograms are the NoXSec ones, so there is nothing to fold
+    if(!xsec.compare("NoXSec")) {
+      std::cout << "NoXSec is not a cross section, so it cannot be folded." << std::endl;
+      return 0;
+    }
+
+    std::string detName = det.GetDetName();
+
+    TDirectory* temp = gDirectory;
+
+    TDirectory* dir = fOut->GetDirectory((spec + "/" + detName).c_str());
+    if(!dir) {
+      std::cout << "Could not find the directory " << spec << "/" << detName << "." << std::endl;
+      temp->cd();
+      return 0;
+    }
+
+    // Histograms have the form title_flav_par_xsec_det; only the flux histograms are folded
+    std::string suffix = "_NoXSec_" + detName;
+
+    int n_fold = 0;
+    double maxFlatErr = 0.; // Largest estimated error from the flat flux in each bin, over every histogram
+
+    TIter iterHist(dir->GetListOfKeys());
+    TKey* keyHist;
+    while((keyHist = (TKey*)iterHist())) {
+      std::string name = keyHist->GetName();
+
+      if(name.size() <= spec.size() + suffix.size() ||
+         name.compare(0, spec.size() + 1, spec + "_") ||
+         name.compare(name.size() - suffix.size(), suffix.size(), suffix)) {
+        continue;
+      }
+
+      // Get the neutrino flavor, which follows the title
+      std::string nuflav = name.substr(spec.size() + 1);
+      nuflav = nuflav.substr(0, nuflav.find('_'));
+
+      // Combined flavors (allnu) have no single cross section, so they are skipped
+      int pdg = 0;
+      for(const auto& flav : NuFlav::AllNuFlavs()) {
+        if(!nuflav.compare(flav.GetName())) {
+          pdg = flav.GetPDG();
+        }
+      }
+      if(pdg == 0) {
+        continue;
+      }
+
+      TH1* flux = (TH1*)dir->Get(name.c_str());
+      double flatErr = 0.;
+      TH1* h = FoldHist(flux, pdg, det.GetTarget(), xsec, precision, flatErr);
+
+      if(h) {
+        // Replace NoXSec in the name by the folded cross section
+        std::string foldName = name;
+        foldName.replace(name.size() - suffix.size() + 1, 6, xsec);
+
+        h->SetName(foldName.c_str());
+        dir->WriteTObject(h, foldName.c_str(), "Overwrite");
+        delete h;
+
+        ++n_fold;
+        maxFlatErr = std::max(maxFlatErr, flatErr);
+      }
+    } // end of loop over histograms
+
+    // Record the new cross section in the Spectra description, so the Combiner picks up the folded histograms
+    TDirectory* specDir = fOut->GetDirectory(spec.c_str());
+    SpectraMeta meta;
+    if(n_fold > 0 && meta.Read(specDir) &&
+       std::find(meta.fXSecs.begin(), meta.fXSecs.end(), xsec) == meta.fXSecs.end()) {
+      meta.fXSecs.push_back(xsec);
+      meta.Write(specDir);
+    }
+
+    std::cout << spec << ": folded " << xsec << " into " << n_fold
+              << " histograms for " << detName << "." << std::endl;
+    if(n_fold > 0) {
+      std::cout << "The largest estimated error of a bin from the flat flux inside it is "
+                << 100.*maxFlatErr << "%." << std::endl;
+    }
+
+    temp->cd();
+    return n_fold;
+  }
+
+  //---------------------------------------------------------------------------
+  TH1* XSecFolder::FoldHist(TH1* flux, int pdg, std::string tar, std::string xsec, double precision,
+                            double& flatErr)
+  {
+    if(flux->GetDimension() != 1) {
+      std::cout << "Only 1D histograms can be folded. Skipping " << flux->GetName() << "." << std::endl;
+      return nullptr;
+    }
+
+    // Same cross section (and event rate scaling) as the per entry weighting in Spectra
+    TSpline3* s = XSecRegistry::Instance().GetXSec(pdg, tar, xsec, true);
+    if(!s) {
+      std::cout << "There is no " << xsec << " cross section for PDG " << pdg << " on " << tar
+                << ". Skipping " << flux->GetName() << "." << std::endl;
+      return nullptr;
+    }
+
+    // Bin averages of the cross section with the same binning as the flux
+    TAxis* ax = flux->GetXaxis();
+    const int n_bins = ax->GetNbins();
+
+    TH1* avg = nullptr;
+    if(ax->GetXbins()->GetSize() > 0) {
+      avg = XSec::GetHist(s, n_bins, ax->GetXbins()->GetArray(), precision);
+    }
+    else {
+      avg = XSec::GetHist(s, n_bins, ax->GetXmin(), ax->GetXmax(), precision);
+    }
+
+    TH1* ret = (TH1*)flux->Clone();
+    ret->SetDirectory(nullptr);
+
+    for(int i = 1; i <= n_bins; ++i) {
+      double xs = avg->GetBinContent(i);
+      ret->SetBinContent(i, flux->GetBinContent(i)*xs);
+      ret->SetBinError  (i, flux->GetBinError(i)  *xs);
+    }
+
+    // Nothing can be said about the cross section outside of the binning
+    ret->SetBinContent(0, 0.);
+    ret->SetBinError  (0, 0.);
+    ret->SetBinContent(n_bins + 1, 0.);
+    ret->SetBinError  (n_bins + 1, 0.);
+
+    flatErr = FlatFluxError(flux, s, avg);
+
+    delete avg;
+    return ret;
+  }
+
+  //---------------------------------------------------------------------------
+  double XSecFolder::FlatFluxError(const TH1* flux, TSpline3* s, const TH1* avg)
+  {
+    const TAxis* ax = flux->GetXaxis();
+    const int n_bins = ax->GetNbins();
+
+    // The fine points of every bin, in increasing order, so the spline is evaluated in one sorted pass
+    std::vector<double> x(n_bins*kNFine);
+    for(int i = 1; i <= n_bins; ++i) {
+      for(int i_fine = 0; i_fine < kNFine; ++i_fine) {
+        x[(i - 1)*kNFine + i_fine] = ax->GetBinLowEdge(i) + (i_fine + 0.5)*ax->GetBinWidth(i)/kNFine;
+      }
+    }
+    std::vector<double> vals = XSec::XSecEval(s, x, true);
+
+    double ret = 0.;
+
+    for(int i = 1; i <= n_bins; ++i) {
+      const double content = flux->GetBinContent(i);
+      const double xs      = avg->GetBinContent(i);
+      if(content <= 0. || xs <= 0.) { continue; }
+
+      // Slope of the flux density from the neighboring bins, or the bin itself at the edges
+      const int lo = std::max(i - 1, 1);
+      const int hi = std::min(i + 1, n_bins);
+      if(lo == hi) { continue; }
+
+      const double slope = (flux->GetBinContent(hi)/ax->GetBinWidth(hi) - flux->GetBinContent(lo)/ax->GetBinWidth(lo))/
+                           (ax->GetBinCenter(hi) - ax->GetBinCenter(lo));
+
+      // A linear flux has the same integral over the bin as a flat one,
+      // so the difference of the folded bins is slope*integral((E - center)*sigma(E))
+      const double width  = ax->GetBinWidth(i);
+      const double center = ax->GetBinCenter(i);
+
+      double moment = 0.;
+      for(int i_fine = (i - 1)*kNFine; i_fine < i*kNFine; ++i_fine) {
+        moment += (x[i_fine] - center)*vals[i_fine];
+      }
+      moment *= width/kNFine;
+
+      ret = std::max(ret, std::fabs(slope*moment)/(content*xs));
+    } // Loop over bins
+
+    return ret;
+  }
+}
@@ -0,0 +1,91 @@
+#include "XSecRegistry.h"
+
+// Root Includes
+#include "TDirectory.h"
+#include "TSpline.h"
+
+// Package Includes
+#include "XSec.h"
+
+namespace flxrd
+{
+  //---------------------------------------------------------------------------
+  XSecRegistry& XSecRegistry::Instance()
+  {
+    // This is intentionally never deleted:
+    // the splines must not be destroyed after ROOT has been torn down at exit
+    static XSecRegistry* registry = new XSecRegistry();
+    return *registry;
+  }
+
+  //---------------------------------------------------------------------------
+  XSecRegistry::XSecRegistry()
+    : fXSec(nullptr)
+  {
+  }
+
+  //---------------------------------------------------------------------------
+  TSpline3* XSecRegistry::GetXSec(int pdg, std::string tar, std::string type, bool eventRate)
+  {
+    // No cross section is an identity factor, so there is no spline to build
+    if(!type.compare("NoXSec")) {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(fMutex);
+
+    Key_t key(pdg, tar, type, eventRate);
+
+    // Return the spline if it has already been built
+    auto it = fSplines.find(key);
+    if(it != fSplines.end()) {
+      return it->second;
+    }
+
+    TSpline3* s = GetXSecObject()->GetXSec(pdg, tar, type, eventRate); // Create the spline
+
+    fSplines[key] = s; // Store it for every later request
+
+    return s;
+  }
+
+  //---------------------------------------------------------------------------
+  XSec* XSecRegistry::GetXSecObject()
+  {
+    // Open the cross section file the first time it is needed
+    if(!fXSec) {
+      TDirectory* temp = gDirectory;
+      fXSec = new XSec();
+      temp->cd();
+    }
+
+    return fXSec;
+  }
+
+  //---------------------------------------------------------------------------
+  bool XSecRegistry::IsValidProcess(std::string type)
+  {
+    if(!type.compare("NoXSec")) {
+      return true;
+    }
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    return GetXSecObject()->IsValidProcess(type);
+  }
+
+  //---------------------------------------------------------------------------
+  void XSecRegistry::ListIntTypes()
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    GetXSecObject()->ListIntTypes();
+
+    return;
+  }
+
+  //---------------------------------------------------------------------------
+  int XSecRegistry::NSplines()
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fSplines.size();
+  }
+}